@@ -0,0 +1,493 @@
+#include "CrossoverEngine.h"
+#include <algorithm>
+#include <cmath>
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::prepare(double newSampleRate, int newNumChannels, int maxBlockSize)
+{
+    juce::ignoreUnused(maxBlockSize);
+
+    sampleRate = newSampleRate;
+    numChannels = std::max(0, newNumChannels);
+    channelStride = ((numChannels + kChannelAlignment - 1) / kChannelAlignment) * kChannelAlignment;
+
+    z1.assign((size_t) (kMaxSections * channelStride), SampleType(0));
+    z2.assign((size_t) (kMaxSections * channelStride), SampleType(0));
+    bandValues.assign((size_t) (kMaxBands * channelStride), SampleType(0));
+    rest.assign((size_t) channelStride, SampleType(0));
+    high.assign((size_t) channelStride, SampleType(0));
+
+    designWorkspace.prepare(sampleRate);
+    firLength = designWorkspace.getFirLength();
+    numPartitions = designWorkspace.getNumPartitions();
+
+    int partitionOrder = 0;
+
+    while ((1 << partitionOrder) < 2 * kPartitionSize)
+        ++partitionOrder;
+
+    partitionFft = std::make_unique<juce::dsp::FFT>(partitionOrder);
+
+    // Playback starts with filters for the current settings, built here rather
+    // than on the audio thread
+    filters.prepare(designWorkspace);
+    previousFilters.prepare(designWorkspace);
+    filters.build(designWorkspace, numBands, frequencies);
+
+    inputSpectra.assign((size_t) (numChannels * numPartitions * kBinStride), 0.0f);
+    inputHistory.assign((size_t) (numChannels * 2 * kPartitionSize), 0.0f);
+    outputFifo.assign((size_t) (kMaxBands * numChannels * kPartitionSize), 0.0f);
+    accumulator.assign((size_t) kBinStride, 0.0f);
+    fftBuffer.assign((size_t) (4 * kPartitionSize), 0.0f);
+
+    sectionsDirty = true;
+    reset();
+}
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::reset()
+{
+    std::fill(z1.begin(), z1.end(), SampleType(0));
+    std::fill(z2.begin(), z2.end(), SampleType(0));
+    std::fill(inputSpectra.begin(), inputSpectra.end(), 0.0f);
+    std::fill(inputHistory.begin(), inputHistory.end(), 0.0f);
+    std::fill(outputFifo.begin(), outputFifo.end(), 0.0f);
+    fifoPosition = 0;
+    spectrumPosition = 0;
+}
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::setNumBands(int newNumBands)
+{
+    newNumBands = juce::jlimit(kMinBands, kMaxBands, newNumBands);
+
+    if (newNumBands == numBands)
+        return;
+
+    // The section layout depends on the band count, so the old state is meaningless
+    numBands = newNumBands;
+    sectionsDirty = true;
+    reset();
+}
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::setCrossoverFrequency(int split, float frequency)
+{
+    if (split < 0 || split >= kMaxSplits || frequencies[(size_t) split] == frequency)
+        return;
+
+    frequencies[(size_t) split] = frequency;
+
+    // Linear phase filters follow in updateFilters(), at the next partition
+    if (split < numBands - 1)
+        sectionsDirty = true;
+}
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::setMode(Mode newMode)
+{
+    if (newMode == mode)
+        return;
+
+    mode = newMode;
+    reset();
+}
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::setDesignInPlace()
+{
+    designInPlace = true;
+    backgroundDesign = nullptr;
+}
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::setDesign(const LinearPhaseDesign* design)
+{
+    designInPlace = false;
+    backgroundDesign = design;
+}
+
+template <typename SampleType>
+bool CrossoverEngine<SampleType>::hasLinearPhaseDesign(int bands) const
+{
+    return designInPlace || filters.getNumBands() == bands
+        || (backgroundDesign != nullptr && backgroundDesign->getNumBands() == bands);
+}
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::copyStateFrom(const CrossoverEngine& other)
+{
+    jassert(other.numChannels == numChannels && other.firLength == firLength && other.mode == mode);
+
+    // Split s runs the same sections on the same signal at every band count, and
+    // its sections come after the same ones of the earlier splits
+    const int sharedSplits = std::min(numBands, other.numBands) - 1;
+    const int sharedValues = (4 * sharedSplits + (sharedSplits * (sharedSplits - 1)) / 2) * channelStride;
+
+    std::copy_n(other.z1.begin(), sharedValues, z1.begin());
+    std::copy_n(other.z2.begin(), sharedValues, z2.begin());
+    std::fill(z1.begin() + sharedValues, z1.end(), SampleType(0));
+    std::fill(z2.begin() + sharedValues, z2.end(), SampleType(0));
+
+    // The input spectra don't depend on the bands at all
+    std::copy(other.inputSpectra.begin(), other.inputSpectra.end(), inputSpectra.begin());
+    std::copy(other.inputHistory.begin(), other.inputHistory.end(), inputHistory.begin());
+    fifoPosition = other.fifoPosition;
+    spectrumPosition = other.spectrumPosition;
+
+    if (mode != Mode::linearPhase)
+        return;
+
+    // The same bands run the other crossover's filters; new ones need filters for
+    // this band count, which the caller has made sure exist
+    if (other.numBands == numBands && other.filters.getNumBands() == numBands)
+        filters.copyFrom(other.filters);
+    else
+        updateFilters();
+
+    // The queued partition was convolved when the previous spectrum was the newest
+    const int numFilteredBands = std::min(numBands, filters.getNumBands());
+    const int newestSpectrum = spectrumPosition;
+    spectrumPosition = (spectrumPosition + numPartitions - 1) % numPartitions;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const float* spectra = inputSpectra.data() + channel * numPartitions * kBinStride;
+
+        for (int band = 0; band < numBands; ++band)
+        {
+            float* output = outputFifo.data() + (band * numChannels + channel) * kPartitionSize;
+
+            if (band >= numFilteredBands)
+            {
+                std::fill_n(output, kPartitionSize, 0.0f);
+                continue;
+            }
+
+            convolveBand(spectra, filters, band);
+            std::copy_n(fftBuffer.begin() + kPartitionSize, kPartitionSize, output);
+        }
+    }
+
+    spectrumPosition = newestSpectrum;
+}
+
+template <typename SampleType>
+int CrossoverEngine<SampleType>::getLatencySamples() const
+{
+    // FIR centre plus one partition of input buffering
+    return mode == Mode::linearPhase ? firLength / 2 + kPartitionSize : 0;
+}
+
+template <typename SampleType>
+int CrossoverEngine<SampleType>::getTailSamples() const
+{
+    // The latency plus the second half of the FIR
+    if (mode == Mode::linearPhase)
+        return firLength + kPartitionSize;
+
+    // The lowest split rings longest. Its Butterworth poles decay at w0 / sqrt(2)
+    // per sample, and the cascaded sections roughly double the time to -120 dB.
+    const double w0 = juce::MathConstants<double>::twoPi * getCrossoverFrequency(0) / sampleRate;
+    return (int) std::ceil(2.0 * std::log(1.0e6) * juce::MathConstants<double>::sqrt2 / w0);
+}
+
+template <typename SampleType>
+SampleType CrossoverEngine<SampleType>::getStateMagnitude() const
+{
+    SampleType magnitude = 0;
+
+    if (mode == Mode::linearPhase)
+    {
+        for (float value : inputHistory)
+            magnitude = std::max(magnitude, (SampleType) std::abs(value));
+
+        for (float value : outputFifo)
+            magnitude = std::max(magnitude, (SampleType) std::abs(value));
+    }
+    else
+    {
+        const int numValues = numSections * channelStride;
+
+        for (int i = 0; i < numValues; ++i)
+            magnitude = std::max({ magnitude, std::abs(z1[(size_t) i]), std::abs(z2[(size_t) i]) });
+    }
+
+    return magnitude;
+}
+
+template <typename SampleType>
+float CrossoverEngine<SampleType>::getCrossoverFrequency(int split) const
+{
+    return getSplitFrequency(frequencies, split, sampleRate);
+}
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::process(const SampleType* const* input, SampleType* const* bandOutputs, int numSamples)
+{
+    if (numChannels == 0 || numSamples <= 0)
+        return;
+
+    if (mode == Mode::linearPhase)
+        processLinearPhase(input, bandOutputs, numSamples);
+    else
+        processLinkwitzRiley(input, bandOutputs, numSamples);
+}
+
+//==============================================================================
+// Second order Butterworth low/high pass and allpass sections (Q = 1/sqrt(2)).
+// Two cascaded Butterworth sections make an LR4 filter, and LR4 low + high pass
+// equals the allpass at the same frequency.
+template <typename SampleType>
+void CrossoverEngine<SampleType>::updateSections()
+{
+    auto makeSection = [this](float frequency, int type)
+    {
+        const double w0 = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const double cosW0 = std::cos(w0);
+        const double alpha = std::sin(w0) / juce::MathConstants<double>::sqrt2; // sin(w0) / (2 * Q)
+        const double a0 = 1.0 + alpha;
+        double b0, b1, b2;
+
+        if (type == 0)          // low pass
+        {
+            b0 = (1.0 - cosW0) * 0.5;
+            b1 = 1.0 - cosW0;
+            b2 = b0;
+        }
+        else if (type == 1)     // high pass
+        {
+            b0 = (1.0 + cosW0) * 0.5;
+            b1 = -(1.0 + cosW0);
+            b2 = b0;
+        }
+        else                    // allpass
+        {
+            b0 = 1.0 - alpha;
+            b1 = -2.0 * cosW0;
+            b2 = 1.0 + alpha;
+        }
+
+        return Section { (SampleType) (b0 / a0), (SampleType) (b1 / a0), (SampleType) (b2 / a0),
+                         (SampleType) (-2.0 * cosW0 / a0), (SampleType) ((1.0 - alpha) / a0) };
+    };
+
+    numSections = 0;
+
+    for (int split = 0; split < numBands - 1; ++split)
+    {
+        const float frequency = getCrossoverFrequency(split);
+        const auto lowPass = makeSection(frequency, 0);
+        const auto highPass = makeSection(frequency, 1);
+        const auto allPass = makeSection(frequency, 2);
+
+        sections[(size_t) numSections++] = lowPass;
+        sections[(size_t) numSections++] = lowPass;
+        sections[(size_t) numSections++] = highPass;
+        sections[(size_t) numSections++] = highPass;
+
+        for (int band = 0; band < split; ++band)
+            sections[(size_t) numSections++] = allPass;
+    }
+
+    sectionsDirty = false;
+}
+
+// Transposed direct form II across all channels of one section. The loop runs
+// over the padded channel count, so it packs whole SIMD registers of channels.
+template <typename SampleType>
+inline void CrossoverEngine<SampleType>::runSection(int section, SampleType* values)
+{
+    const auto& c = sections[(size_t) section];
+    SampleType* s1 = z1.data() + section * channelStride;
+    SampleType* s2 = z2.data() + section * channelStride;
+
+    for (int channel = 0; channel < channelStride; ++channel)
+    {
+        const SampleType x = values[channel];
+        const SampleType y = c.b0 * x + s1[channel];
+        s1[channel] = c.b1 * x - c.a1 * y + s2[channel];
+        s2[channel] = c.b2 * x - c.a2 * y;
+        values[channel] = y;
+    }
+}
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::processLinkwitzRiley(const SampleType* const* input, SampleType* const* bandOutputs, int numSamples)
+{
+    if (sectionsDirty)
+        updateSections();
+
+    const int numSplits = numBands - 1;
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            rest[(size_t) channel] = input[channel][sample];
+
+        int section = 0;
+
+        for (int split = 0; split < numSplits; ++split)
+        {
+            SampleType* low = bandValues.data() + split * channelStride;
+            std::copy(rest.begin(), rest.end(), low);
+            std::copy(rest.begin(), rest.end(), high.begin());
+
+            runSection(section++, low);
+            runSection(section++, low);
+            runSection(section++, high.data());
+            runSection(section++, high.data());
+
+            // Phase-align the bands already split off with this crossover
+            for (int band = 0; band < split; ++band)
+                runSection(section++, bandValues.data() + band * channelStride);
+
+            std::swap(rest, high);
+        }
+
+        std::copy(rest.begin(), rest.end(), bandValues.begin() + numSplits * channelStride);
+
+        for (int band = 0; band < numBands; ++band)
+            for (int channel = 0; channel < numChannels; ++channel)
+                bandOutputs[band * numChannels + channel][sample] = bandValues[(size_t) (band * channelStride + channel)];
+    }
+}
+
+//==============================================================================
+// Takes new filters for the current band count and frequencies, built in place
+// or from the background design. Returns true if the outgoing filters cover the
+// same bands, so the next partition can crossfade between the two.
+template <typename SampleType>
+bool CrossoverEngine<SampleType>::updateFilters()
+{
+    if (designInPlace)
+    {
+        if (filters.matches(numBands, frequencies))
+            return false;
+
+        std::swap(filters, previousFilters);
+        filters.build(designWorkspace, numBands, frequencies);
+    }
+    else
+    {
+        // A design for another band count or sample rate waits; the current
+        // filters keep running until a matching one arrives
+        if (backgroundDesign == nullptr || backgroundDesign->getNumBands() != numBands
+            || backgroundDesign->getFirLength() != firLength || filters.matches(*backgroundDesign))
+            return false;
+
+        std::swap(filters, previousFilters);
+        filters.copyFrom(*backgroundDesign);
+    }
+
+    return previousFilters.getNumBands() == numBands;
+}
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::processLinearPhase(const SampleType* const* input, SampleType* const* bandOutputs, int numSamples)
+{
+    int sample = 0;
+
+    while (sample < numSamples)
+    {
+        const int count = std::min(numSamples - sample, kPartitionSize - fifoPosition);
+
+        // New input goes into the second half of each channel's history; the output
+        // comes from the partition computed one partition ago (both convert to and
+        // from float for double processing)
+        for (int channel = 0; channel < numChannels; ++channel)
+            std::copy_n(input[channel] + sample, count,
+                        inputHistory.begin() + channel * 2 * kPartitionSize + kPartitionSize + fifoPosition);
+
+        for (int lane = 0; lane < numBands * numChannels; ++lane)
+            std::copy_n(outputFifo.begin() + lane * kPartitionSize + fifoPosition, count, bandOutputs[lane] + sample);
+
+        fifoPosition += count;
+        sample += count;
+
+        if (fifoPosition == kPartitionSize)
+        {
+            processPartition();
+            fifoPosition = 0;
+        }
+    }
+}
+
+template <typename SampleType>
+void CrossoverEngine<SampleType>::processPartition()
+{
+    // Filters change only here, between partitions of output. Bands the filters
+    // don't cover yet stay silent; TransformerEngine waits for a design instead.
+    const bool crossfade = updateFilters();
+    const int numFilteredBands = std::min(numBands, filters.getNumBands());
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* history = inputHistory.data() + channel * 2 * kPartitionSize;
+        float* spectra = inputSpectra.data() + channel * numPartitions * kBinStride;
+
+        // Spectrum of the last two partitions of input
+        std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+        std::copy_n(history, 2 * kPartitionSize, fftBuffer.begin());
+        partitionFft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+        std::copy_n(fftBuffer.begin(), kBinStride, spectra + spectrumPosition * kBinStride);
+        std::copy_n(history + kPartitionSize, kPartitionSize, history);
+
+        for (int band = 0; band < numBands; ++band)
+        {
+            float* output = outputFifo.data() + (band * numChannels + channel) * kPartitionSize;
+
+            if (band >= numFilteredBands)
+            {
+                std::fill_n(output, kPartitionSize, 0.0f);
+                continue;
+            }
+
+            convolveBand(spectra, filters, band);
+            std::copy_n(fftBuffer.begin() + kPartitionSize, kPartitionSize, output);
+
+            // The same input through the old filters, faded out over this partition
+            if (crossfade)
+            {
+                convolveBand(spectra, previousFilters, band);
+                const float* previous = fftBuffer.data() + kPartitionSize;
+
+                for (int i = 0; i < kPartitionSize; ++i)
+                    output[i] = previous[i] + (output[i] - previous[i]) * (float) (i + 1) / (float) kPartitionSize;
+            }
+        }
+    }
+
+    spectrumPosition = (spectrumPosition + 1) % numPartitions;
+}
+
+// Overlap-save: the second half of fftBuffer is this partition's valid output
+template <typename SampleType>
+void CrossoverEngine<SampleType>::convolveBand(const float* spectra, const LinearPhaseDesign& design, int band)
+{
+    const int numBins = kPartitionSize + 1;
+    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+
+    for (int partition = 0; partition < numPartitions; ++partition)
+    {
+        const int slot = (spectrumPosition - partition + numPartitions) % numPartitions;
+        const float* x = spectra + slot * kBinStride;
+        const float* h = design.getSpectrum(band, partition);
+        float* acc = accumulator.data();
+
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            const float xr = x[2 * bin], xi = x[2 * bin + 1];
+            const float hr = h[2 * bin], hi = h[2 * bin + 1];
+            acc[2 * bin]     += xr * hr - xi * hi;
+            acc[2 * bin + 1] += xr * hi + xi * hr;
+        }
+    }
+
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+    std::copy(accumulator.begin(), accumulator.end(), fftBuffer.begin());
+    partitionFft->performRealOnlyInverseTransform(fftBuffer.data());
+}
+
+template class CrossoverEngine<float>;
+template class CrossoverEngine<double>;
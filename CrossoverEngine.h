@@ -0,0 +1,141 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include "CrossoverLayout.h"
+#include "LinearPhaseDesign.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+// N-band crossover (2 to 5 bands) feeding the transformer model bank.
+//
+// Linkwitz-Riley mode splits with LR4 sections in a tree: each split takes the
+// low band off the remaining signal, and the bands already split off pass through
+// the LR4 allpass of every later split, so the bands sum to an allpass response.
+// All channels advance together sample by sample, with the biquad state for each
+// section stored as one contiguous array per state variable (section-major,
+// channels innermost, padded to kChannelAlignment so the channel loops vectorise).
+//
+// Linear-phase mode runs zero-phase FIRs with the same LR4 magnitudes (which
+// sum exactly to one, see LinearPhaseDesign) with uniformly partitioned FFT
+// convolution. The bands sum to a pure delay of getLatencySamples(). New filters
+// for moved frequencies are built in place or handed in from a background
+// builder, and the first partition convolved with them crossfades from the old
+// filters' output.
+//
+// Band outputs are laid out as bandOutputs[band * numChannels + channel].
+//
+// SampleType is float or double (both instantiated in CrossoverEngine.cpp). The
+// Linkwitz-Riley state runs at full SampleType precision; juce::dsp::FFT only
+// transforms floats, so the linear-phase path convolves in float either way.
+
+template <typename SampleType>
+class CrossoverEngine : public CrossoverLayout
+{
+public:
+    // Allocates all storage for kMaxBands and both modes, and builds the linear
+    // phase filters for the current band count and frequencies
+    void prepare(double sampleRate, int numChannels, int maxBlockSize);
+    void reset();
+
+    void setNumBands(int numBands);
+    int getNumBands() const { return numBands; }
+
+    // Crossover frequency between band split and split + 1. Frequencies are kept
+    // ascending and below Nyquist.
+    void setCrossoverFrequency(int split, float frequency);
+
+    void setMode(Mode newMode);
+    Mode getMode() const { return mode; }
+
+    // Where linear phase filters for new settings come from. By default they are
+    // built in place on the processing thread, which offline renders rely on for
+    // repeatable output. setDesign() takes the latest design from a
+    // LinearPhaseDesignBuilder instead (nullptr until it has one); the crossover
+    // keeps its current filters until a design for its band count arrives.
+    void setDesignInPlace();
+    void setDesign(const LinearPhaseDesign* design);
+
+    // True if linear phase mode can run numBands bands now
+    bool hasLinearPhaseDesign(int numBands) const;
+
+    // Continues from another crossover prepared the same way and running the
+    // same mode, at this crossover's band count: the splits both have keep their
+    // filter memory, and linear phase keeps the input history and recomputes the
+    // partition already queued for output. Lets a second crossover take over
+    // mid-stream without the transient of starting empty.
+    void copyStateFrom(const CrossoverEngine& other);
+
+    // Delay introduced by the current mode (zero for Linkwitz-Riley)
+    int getLatencySamples() const;
+
+    // Samples until the bands have fallen 120 dB below an input that stopped,
+    // including the latency
+    int getTailSamples() const;
+
+    // Largest value held in the filter memory of the current mode
+    SampleType getStateMagnitude() const;
+
+    int getNumChannels() const { return numChannels; }
+
+    void process(const SampleType* const* input, SampleType* const* bandOutputs, int numSamples);
+
+private:
+    struct Section
+    {
+        SampleType b0, b1, b2, a1, a2;
+    };
+
+    void updateSections();
+    void processLinkwitzRiley(const SampleType* const* input, SampleType* const* bandOutputs, int numSamples);
+    void runSection(int section, SampleType* values);
+
+    bool updateFilters();
+    void processLinearPhase(const SampleType* const* input, SampleType* const* bandOutputs, int numSamples);
+    void processPartition();
+    void convolveBand(const float* inputSpectra, const LinearPhaseDesign& design, int band);
+
+    float getCrossoverFrequency(int split) const;
+
+    double sampleRate = 44100.0;
+    int numChannels = 0;
+    int channelStride = 0;
+    int numBands = kMinBands;
+    Mode mode = Mode::linkwitzRiley;
+    Frequencies frequencies { 1000.0f, 4000.0f, 8000.0f, 12000.0f };
+    bool sectionsDirty = true;
+
+    //==============================================================================
+    // Linkwitz-Riley: 4 sections per split plus one allpass per earlier band
+    static constexpr int kMaxSections = 4 * kMaxSplits + (kMaxSplits * (kMaxSplits - 1)) / 2;
+
+    std::array<Section, kMaxSections> sections {};
+    int numSections = 0;
+    std::vector<SampleType> z1, z2;         // [section * channelStride + channel]
+    std::vector<SampleType> bandValues;     // [band * channelStride + channel]
+    std::vector<SampleType> rest, high;     // [channel], channelStride long
+
+    //==============================================================================
+    // Linear phase: uniformly partitioned overlap-save convolution
+    static constexpr int kPartitionSize = LinearPhaseDesign::kPartitionSize;
+    static constexpr int kBinStride = LinearPhaseDesign::kBinStride;
+
+    int firLength = 0;
+    int numPartitions = 0;
+    int fifoPosition = 0;
+    int spectrumPosition = 0;
+
+    std::unique_ptr<juce::dsp::FFT> partitionFft;   // 2 * kPartitionSize points
+
+    // The filters in use, and the ones they replaced while the partition after
+    // a change crossfades between them
+    LinearPhaseDesign filters, previousFilters;
+    LinearPhaseDesign::Workspace designWorkspace;   // for in-place builds
+    const LinearPhaseDesign* backgroundDesign = nullptr;
+    bool designInPlace = true;
+
+    std::vector<float> inputSpectra;    // [(channel * numPartitions + partition) * binStride]
+    std::vector<float> inputHistory;    // [channel * 2 * kPartitionSize], previous + current partition
+    std::vector<float> outputFifo;      // [(band * numChannels + channel) * kPartitionSize]
+    std::vector<float> accumulator;     // binStride
+    std::vector<float> fftBuffer;       // 2 * fft size
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <algorithm>
+#include <array>
+
+// Limits and modes shared by the crossover, its linear phase filter designs and
+// every sample type
+struct CrossoverLayout
+{
+    static constexpr int kMinBands = 2;
+    static constexpr int kMaxBands = 5;
+    static constexpr int kMaxSplits = kMaxBands - 1;
+
+    // Channel state is padded to a multiple of this many channels (one SSE/NEON register)
+    static constexpr int kChannelAlignment = 4;
+
+    enum class Mode
+    {
+        linkwitzRiley,
+        linearPhase
+    };
+
+    using Frequencies = std::array<float, kMaxSplits>;
+
+    // Frequency a split actually runs at: kept between 20 Hz and 0.45 of the
+    // sample rate, and no lower than any split before it
+    static float getSplitFrequency(const Frequencies& frequencies, int split, double sampleRate)
+    {
+        const float nyquistLimit = (float) (sampleRate * 0.45);
+        float frequency = std::clamp(frequencies[(size_t) split], 20.0f, nyquistLimit);
+
+        for (int previous = 0; previous < split; ++previous)
+            frequency = std::max(frequency, std::clamp(frequencies[(size_t) previous], 20.0f, nyquistLimit));
+
+        return frequency;
+    }
+};
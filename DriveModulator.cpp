@@ -0,0 +1,124 @@
+#include "DriveModulator.h"
+#include <cmath>
+
+template <typename SampleType>
+void DriveModulator<SampleType>::prepare(double sampleRate)
+{
+    mSampleRate = sampleRate;
+    mDepth.reset(sampleRate, 0.05);
+    updateCoefficients();
+    reset();
+}
+
+template <typename SampleType>
+void DriveModulator<SampleType>::reset()
+{
+    mDepth.setCurrentAndTargetValue(mDepth.getTargetValue());
+    mEnvelope = 0;
+}
+
+template <typename SampleType>
+void DriveModulator<SampleType>::setMode(Mode mode)
+{
+    // A fresh follower, so switching modes never starts from a stale envelope
+    if (mode != mMode)
+        mEnvelope = 0;
+
+    mMode = mode;
+}
+
+template <typename SampleType>
+void DriveModulator<SampleType>::setDepth(float depth)
+{
+    mDepth.setTargetValue((SampleType) depth);
+}
+
+template <typename SampleType>
+void DriveModulator<SampleType>::setAttackRelease(float attackMs, float releaseMs)
+{
+    if (attackMs == mAttackMs && releaseMs == mReleaseMs)
+        return;
+
+    mAttackMs = attackMs;
+    mReleaseMs = releaseMs;
+    updateCoefficients();
+}
+
+template <typename SampleType>
+bool DriveModulator<SampleType>::isActive() const
+{
+    return mMode != Mode::off && (mDepth.isSmoothing() || mDepth.getTargetValue() != SampleType(0));
+}
+
+// One-pole time constants: the envelope covers 1 - 1/e of a step within the time
+template <typename SampleType>
+void DriveModulator<SampleType>::updateCoefficients()
+{
+    const auto coefficient = [this](float ms)
+    {
+        const double samples = juce::jmax(1.0, (double) ms * 0.001 * mSampleRate);
+        return (SampleType) std::exp(-1.0 / samples);
+    };
+
+    mAttackCoefficient = coefficient(mAttackMs);
+    mReleaseCoefficient = coefficient(mReleaseMs);
+}
+
+template <typename SampleType>
+SampleType DriveModulator<SampleType>::getNextModulation(const juce::AudioBuffer<SampleType>& sidechain, int sample)
+{
+    const int numChannels = sidechain.getNumChannels();
+
+    if (mMode == Mode::direct)
+    {
+        SampleType sum = 0;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            sum += sidechain.getSample(channel, sample);
+
+        return sum / (SampleType) numChannels;
+    }
+
+    // Peak follower across all sidechain channels
+    SampleType peak = 0;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        peak = juce::jmax(peak, std::abs(sidechain.getSample(channel, sample)));
+
+    const SampleType coefficient = peak > mEnvelope ? mAttackCoefficient : mReleaseCoefficient;
+    mEnvelope = peak + coefficient * (mEnvelope - peak);
+    return mEnvelope;
+}
+
+template <typename SampleType>
+void DriveModulator<SampleType>::process(const juce::AudioBuffer<SampleType>& sidechain, int startSample,
+                                         SampleType* driveRamp, int numSamples)
+{
+    if (mMode == Mode::off || sidechain.getNumChannels() == 0)
+    {
+        mDepth.skip(numSamples);
+        return;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const SampleType modulation = getNextModulation(sidechain, startSample + i);
+        driveRamp[i] *= juce::jmax(SampleType(0), 1 + mDepth.getNextValue() * modulation);
+    }
+}
+
+template <typename SampleType>
+void DriveModulator<SampleType>::skip(const juce::AudioBuffer<SampleType>& sidechain, int startSample, int numSamples)
+{
+    mDepth.skip(numSamples);
+
+    // Only the follower has state worth keeping
+    if (mMode != Mode::envelope || sidechain.getNumChannels() == 0)
+        return;
+
+    for (int i = 0; i < numSamples; ++i)
+        getNextModulation(sidechain, startSample + i);
+}
+
+template class DriveModulator<float>;
+template class DriveModulator<double>;
@@ -0,0 +1,55 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+
+// Audio-rate drive modulation from the sidechain bus. The modulation signal m is
+// either the sidechain itself (channel average, direct) or a peak envelope across
+// its channels (attack/release follower); the drive ramp is scaled by
+// max(0, 1 + depth * m), so positive depth pushes the saturation with the
+// sidechain and negative depth ducks it.
+//
+// The modulator only rewrites the drive ramp the model bank already reads per
+// sample, so the model's inner loop costs the same with modulation on or off.
+template <typename SampleType>
+class DriveModulator
+{
+public:
+    enum class Mode
+    {
+        off,
+        direct,
+        envelope
+    };
+
+    void prepare(double sampleRate);
+    void reset();
+
+    void setMode(Mode mode);
+    void setDepth(float depth);
+    void setAttackRelease(float attackMs, float releaseMs);
+
+    // False when off or with no depth to apply (a depth still ramping to zero
+    // counts as active)
+    bool isActive() const;
+
+    // Scales numSamples of driveRamp by the modulation taken from the sidechain,
+    // starting at startSample
+    void process(const juce::AudioBuffer<SampleType>& sidechain, int startSample, SampleType* driveRamp, int numSamples);
+
+    // Advances the envelope and the depth ramp without a drive ramp, while the
+    // signal path is idle
+    void skip(const juce::AudioBuffer<SampleType>& sidechain, int startSample, int numSamples);
+
+private:
+    SampleType getNextModulation(const juce::AudioBuffer<SampleType>& sidechain, int sample);
+    void updateCoefficients();
+
+    double mSampleRate = 44100.0;
+    Mode mMode = Mode::off;
+    juce::SmoothedValue<SampleType> mDepth;
+
+    float mAttackMs = 5.0f;
+    float mReleaseMs = 100.0f;
+    SampleType mAttackCoefficient = 0;
+    SampleType mReleaseCoefficient = 0;
+    SampleType mEnvelope = 0;
+};
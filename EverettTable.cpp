@@ -0,0 +1,80 @@
+#include "EverettTable.h"
+#include <cmath>
+
+EverettTable::EverettTable()
+    : mValues((size_t) ((kMaxResolution + 1) * (kMaxResolution + 1)), 0.0f),
+      mCoerciveDensity((size_t) (kMaxResolution + 1), 0.0),
+      mInteractionDensity((size_t) (2 * kMaxResolution + 1), 0.0),
+      mColumnSums((size_t) (kMaxResolution + 1), 0.0)
+{
+    build(kDefaultResolution, kDefaultWidth);
+}
+
+// E(alpha_i, beta_j) sums the hysteron weights in the triangle beta_j <= beta <
+// alpha <= alpha_i. The density factorises into a coercive term in (alpha - beta)
+// and an interaction term in (alpha + beta), so only 3 * resolution exponentials
+// are needed, and each row follows from the previous one with a running sum.
+void EverettTable::build(int resolution, float width)
+{
+    const int n = std::clamp(resolution, kMinResolution, kMaxResolution);
+    const int rowSize = n + 1;
+    const double halfStep = kInputRange / n;
+
+    const double coercivity = 0.5 * width;
+    const double coerciveSpread = 0.05 + 0.25 * width;
+    const double interactionSpread = 0.8;
+
+    for (int d = 0; d <= n; ++d)
+    {
+        const double h = (d * halfStep - coercivity) / coerciveSpread;
+        mCoerciveDensity[(size_t) d] = std::exp(-0.5 * h * h);
+    }
+
+    for (int s = 0; s <= 2 * n; ++s)
+    {
+        const double field = (s * halfStep - kInputRange) / interactionSpread;
+        mInteractionDensity[(size_t) s] = std::exp(-0.5 * field * field);
+    }
+
+    // Rows are summed in double and only stored as float
+    float* table = mValues.data();
+    std::fill_n(table, rowSize * rowSize, 0.0f);
+    std::fill_n(mColumnSums.data(), rowSize, 0.0);
+
+    for (int i = 1; i <= n; ++i)
+    {
+        float* row = table + i * rowSize;
+        double sum = 0.0;
+
+        for (int j = i - 1; j >= 0; --j)
+        {
+            sum += mCoerciveDensity[(size_t) (i - j)] * mInteractionDensity[(size_t) (i + j)];
+            mColumnSums[(size_t) j] += sum;
+            row[j] = static_cast<float>(mColumnSums[(size_t) j]);
+        }
+    }
+
+    const double total = mColumnSums[0];
+
+    // Full positive saturation swings the output by 2
+    const double norm = total > 0.0 ? 1.0 / total : 0.0;
+
+    for (int k = 0; k < rowSize * rowSize; ++k)
+        table[k] = static_cast<float>(static_cast<double>(table[k]) * norm);
+
+    mResolution = n;
+    mWidth = width;
+}
+
+bool EverettTable::matches(int resolution, float width) const
+{
+    return std::clamp(resolution, kMinResolution, kMaxResolution) == mResolution && width == mWidth;
+}
+
+void EverettTable::copyFrom(const EverettTable& other)
+{
+    const int rowSize = other.mResolution + 1;
+    std::copy_n(other.mValues.data(), rowSize * rowSize, mValues.data());
+    mResolution = other.mResolution;
+    mWidth = other.mWidth;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+
+// Everett function of the Preisach operator (see PreisachOperator) for one grid
+// resolution and loop width, sampled at the grid points over
+// [-kInputRange, kInputRange] and read back with bilinear interpolation.
+//
+// Building takes O(resolution^2) additions and 3 * resolution exponentials, too
+// much to repeat on the audio thread while the width moves, so realtime
+// playback takes tables from an EverettTableBuilder and offline renders build
+// them in place.
+class EverettTable
+{
+public:
+    static constexpr int kMinResolution = 32;
+    static constexpr int kMaxResolution = 256;
+    static constexpr int kDefaultResolution = 64;
+    static constexpr float kDefaultWidth = 0.2f;
+    static constexpr float kInputRange = 4.0f;
+
+    // Allocates storage for kMaxResolution and builds the default table
+    EverettTable();
+
+    // Integrates the density for these settings (resolution clamped to
+    // kMinResolution..kMaxResolution); allocation-free, safe on any thread
+    void build(int resolution, float width);
+
+    // True if the table holds exactly these settings
+    bool matches(int resolution, float width) const;
+
+    // Takes over another table's settings and values without allocating
+    void copyFrom(const EverettTable& other);
+
+    int getResolution() const { return mResolution; }
+    float getWidth() const { return mWidth; }
+
+    // E(alpha, beta), zero unless alpha > beta
+    template <typename SampleType>
+    SampleType evaluate(SampleType alpha, SampleType beta) const
+    {
+        if (alpha <= beta)
+            return SampleType(0);
+
+        const SampleType invStep = static_cast<SampleType>(mResolution) / (2 * static_cast<SampleType>(kInputRange));
+        const SampleType a = (alpha + static_cast<SampleType>(kInputRange)) * invStep;
+        const SampleType b = (beta + static_cast<SampleType>(kInputRange)) * invStep;
+        const int i = std::min(static_cast<int>(a), mResolution - 1);
+        const int j = std::min(static_cast<int>(b), mResolution - 1);
+        const SampleType fa = a - static_cast<SampleType>(i);
+        const SampleType fb = b - static_cast<SampleType>(j);
+
+        const int rowSize = mResolution + 1;
+        const float* row0 = mValues.data() + i * rowSize + j;
+        const float* row1 = row0 + rowSize;
+
+        const SampleType e0 = row0[0] + (SampleType(row0[1]) - row0[0]) * fb;
+        const SampleType e1 = row1[0] + (SampleType(row1[1]) - row1[0]) * fb;
+        return e0 + (e1 - e0) * fa;
+    }
+
+private:
+    int mResolution = kDefaultResolution;
+    float mWidth = kDefaultWidth;
+
+    // E(alpha_i, beta_j) at [i * (resolution + 1) + j], zero for i <= j
+    std::vector<float> mValues;
+    std::vector<double> mCoerciveDensity;     // indexed by alpha_i - beta_j in cells
+    std::vector<double> mInteractionDensity;  // indexed by alpha_i + beta_j in cells
+    std::vector<double> mColumnSums;          // E(alpha_i, beta_j) of the row being built
+};
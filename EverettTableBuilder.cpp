@@ -0,0 +1,99 @@
+#include "EverettTableBuilder.h"
+
+EverettTableBuilder::EverettTableBuilder(int numTargets)
+    : juce::Thread("Everett table builder"),
+      targets((size_t) juce::jmax(1, numTargets))
+{
+}
+
+EverettTableBuilder::~EverettTableBuilder()
+{
+    stop();
+}
+
+void EverettTableBuilder::start()
+{
+    if (! isThreadRunning())
+        startThread();
+}
+
+void EverettTableBuilder::stop()
+{
+    stopThread(1000);
+}
+
+void EverettTableBuilder::request(int target, int resolution, float width)
+{
+    jassert(target >= 0 && target < (int) targets.size());
+    auto& state = targets[(size_t) target];
+
+    // The audio thread requests the live target every block, so unchanged
+    // settings return here without touching the thread's event
+    if (state.requested.load(std::memory_order_relaxed)
+        && state.requestedResolution.load(std::memory_order_relaxed) == resolution
+        && state.requestedWidth.load(std::memory_order_relaxed) == width)
+        return;
+
+    state.requestedResolution.store(resolution, std::memory_order_relaxed);
+    state.requestedWidth.store(width, std::memory_order_relaxed);
+    state.requested.store(true, std::memory_order_release);
+    state.dirty.store(true, std::memory_order_seq_cst);
+    notify();
+}
+
+const EverettTable* EverettTableBuilder::acquire(int target)
+{
+    jassert(target >= 0 && target < (int) targets.size());
+    auto& state = targets[(size_t) target];
+    const int pending = state.pendingSlot.load(std::memory_order_acquire);
+
+    if (pending >= 0)
+    {
+        state.activeSlot.store(pending, std::memory_order_relaxed);
+
+        // Hands the old slot back to the builder, which skipped any newer
+        // request while the slot was taken. Sequentially consistent, so either
+        // this sees that request or the builder sees the free slot.
+        state.pendingSlot.store(-1, std::memory_order_seq_cst);
+
+        if (state.dirty.load(std::memory_order_seq_cst))
+            notify();
+    }
+
+    const int active = state.activeSlot.load(std::memory_order_relaxed);
+    return active >= 0 ? &state.tables[(size_t) active] : nullptr;
+}
+
+void EverettTableBuilder::run()
+{
+    while (! threadShouldExit())
+    {
+        for (auto& state : targets)
+        {
+            // Wait until the audio thread has taken the last table before reusing
+            // its slot; acquire() wakes the thread again then
+            if (state.pendingSlot.load(std::memory_order_seq_cst) >= 0)
+                continue;
+
+            // Cleared before reading the settings, so a request landing meanwhile
+            // builds again
+            if (! state.dirty.exchange(false, std::memory_order_seq_cst))
+                continue;
+
+            const int active = state.activeSlot.load(std::memory_order_relaxed);
+            const int resolution = state.requestedResolution.load(std::memory_order_relaxed);
+            const float width = state.requestedWidth.load(std::memory_order_relaxed);
+
+            if (active < 0 || ! state.tables[(size_t) active].matches(resolution, width))
+            {
+                const int slot = active == 0 ? 1 : 0;
+                state.tables[(size_t) slot].build(resolution, width);
+                state.pendingSlot.store(slot, std::memory_order_release);
+            }
+        }
+
+        // Until request() or acquire() has more work; a notify() that came
+        // during the pass above is not lost
+        wait(-1);
+    }
+}
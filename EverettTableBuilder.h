@@ -0,0 +1,58 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "EverettTable.h"
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Builds EverettTables on a background thread and hands them to the audio thread
+// through a lock-free double buffer per target, like ShaperTableBuilder.
+//
+// Each target is an independent table the caller requests a resolution and loop
+// width for. Targets that were never requested are not built. The Preisach
+// operator copies a table it takes over into its own storage, so the slot is
+// free again once acquire() has returned a newer one.
+//
+// The thread sleeps until request() changes a target's settings, or until the
+// audio thread picks up a table while a newer request is waiting for its slot.
+class EverettTableBuilder : private juce::Thread
+{
+public:
+    explicit EverettTableBuilder(int numTargets = 1);
+    ~EverettTableBuilder() override;
+
+    // Message thread
+    void start();
+    void stop();
+
+    // Any thread
+    bool isRunning() const { return isThreadRunning(); }
+
+    // Any thread: settings the target's next table should be built for. Wakes the
+    // builder only when they differ from the last request.
+    void request(int target, int resolution, float width);
+
+    // Audio thread: takes a newly published table for the target if there is one
+    // and returns its current table, or nullptr until the first one is ready
+    const EverettTable* acquire(int target);
+
+private:
+    void run() override;
+
+    struct Target
+    {
+        std::array<EverettTable, 2> tables;
+        std::atomic<int> activeSlot { -1 };     // slot the audio thread reads, -1 before the first table
+        std::atomic<int> pendingSlot { -1 };    // finished slot waiting for the audio thread
+
+        std::atomic<bool> requested { false };
+        std::atomic<bool> dirty { false };      // requested settings the builder hasn't looked at yet
+        std::atomic<int> requestedResolution { EverettTable::kDefaultResolution };
+        std::atomic<float> requestedWidth { EverettTable::kDefaultWidth };
+    };
+
+    // Sized once at construction, never resized
+    std::vector<Target> targets;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EverettTableBuilder)
+};
@@ -0,0 +1,119 @@
+#include "LinearPhaseDesign.h"
+#include <cmath>
+
+void LinearPhaseDesign::Workspace::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    const int firOrder = juce::jlimit(10, 14, (int) std::ceil(std::log2(sampleRate * 0.04)));
+    firLength = 1 << firOrder;
+
+    int partitionOrder = 0;
+
+    while ((1 << partitionOrder) < 2 * kPartitionSize)
+        ++partitionOrder;
+
+    designFft = std::make_unique<juce::dsp::FFT>(firOrder);
+    partitionFft = std::make_unique<juce::dsp::FFT>(partitionOrder);
+    designBuffer.assign((size_t) (2 * firLength), 0.0f);
+    partitionBuffer.assign((size_t) (4 * kPartitionSize), 0.0f);
+}
+
+void LinearPhaseDesign::prepare(const Workspace& workspace)
+{
+    sampleRate = workspace.getSampleRate();
+    firLength = workspace.getFirLength();
+    numPartitions = workspace.getNumPartitions();
+    numBands = 0;
+    spectra.assign((size_t) (CrossoverLayout::kMaxBands * numPartitions * kBinStride), 0.0f);
+}
+
+void LinearPhaseDesign::build(Workspace& workspace, int newNumBands, const CrossoverLayout::Frequencies& newFrequencies)
+{
+    jassert(workspace.getFirLength() == firLength);
+
+    numBands = juce::jlimit(CrossoverLayout::kMinBands, CrossoverLayout::kMaxBands, newNumBands);
+    frequencies = {};
+
+    for (int split = 0; split < numBands - 1; ++split)
+        frequencies[(size_t) split] = CrossoverLayout::getSplitFrequency(newFrequencies, split, sampleRate);
+
+    const int numBins = firLength / 2 + 1;
+    const int centre = firLength / 2;
+    auto& designBuffer = workspace.designBuffer;
+    auto& partitionBuffer = workspace.partitionBuffer;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        std::fill(designBuffer.begin(), designBuffer.end(), 0.0f);
+
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            const double frequency = bin * sampleRate / firLength;
+            double magnitude = 1.0;
+
+            for (int split = 0; split < numBands - 1 && split <= band; ++split)
+            {
+                double lowPass = 0.0;
+
+                if (bin < numBins - 1)
+                {
+                    const double w = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate)
+                                   / std::tan(juce::MathConstants<double>::pi * frequencies[(size_t) split] / sampleRate);
+                    lowPass = 1.0 / (1.0 + w * w * w * w);
+                }
+
+                magnitude *= (split == band) ? lowPass : 1.0 - lowPass;
+            }
+
+            designBuffer[(size_t) (2 * bin)] = (float) magnitude;
+        }
+
+        workspace.designFft->performRealOnlyInverseTransform(designBuffer.data());
+
+        // Centre the impulse, apply a Hann window and split it into partitions
+        for (int partition = 0; partition < numPartitions; ++partition)
+        {
+            std::fill(partitionBuffer.begin(), partitionBuffer.end(), 0.0f);
+
+            for (int i = 0; i < kPartitionSize; ++i)
+            {
+                const int n = partition * kPartitionSize + i;
+                const int offset = n - centre;
+                const float window = 0.5f + 0.5f * (float) std::cos(juce::MathConstants<double>::pi * offset / centre);
+                partitionBuffer[(size_t) i] = designBuffer[(size_t) ((offset + firLength) % firLength)] * window;
+            }
+
+            workspace.partitionFft->performRealOnlyForwardTransform(partitionBuffer.data(), true);
+            std::copy_n(partitionBuffer.begin(), kBinStride,
+                        spectra.begin() + (band * numPartitions + partition) * kBinStride);
+        }
+    }
+}
+
+bool LinearPhaseDesign::matches(int otherNumBands, const CrossoverLayout::Frequencies& otherFrequencies) const
+{
+    if (numBands == 0 || otherNumBands != numBands)
+        return false;
+
+    for (int split = 0; split < numBands - 1; ++split)
+        if (CrossoverLayout::getSplitFrequency(otherFrequencies, split, sampleRate) != frequencies[(size_t) split])
+            return false;
+
+    return true;
+}
+
+bool LinearPhaseDesign::matches(const LinearPhaseDesign& other) const
+{
+    return numBands > 0 && other.numBands == numBands && other.firLength == firLength
+        && other.frequencies == frequencies;
+}
+
+void LinearPhaseDesign::copyFrom(const LinearPhaseDesign& other)
+{
+    jassert(other.firLength == firLength && other.spectra.size() == spectra.size());
+
+    numBands = other.numBands;
+    frequencies = other.frequencies;
+    std::copy_n(other.spectra.begin(), (size_t) (numBands * numPartitions * kBinStride), spectra.begin());
+}
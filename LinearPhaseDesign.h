@@ -0,0 +1,79 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include "CrossoverLayout.h"
+#include <memory>
+#include <vector>
+
+// Linear phase crossover filters for one band count and set of split
+// frequencies, as the partition spectra CrossoverEngine convolves with.
+//
+// The bands are zero-phase FIRs with the LR4 magnitudes |LP| = 1 / (1 + w^4) and
+// |HP| = w^4 / (1 + w^4), which sum to one at every frequency, so the windowed
+// impulses still sum to a unit impulse at the FIR centre.
+//
+// Building takes a large inverse FFT and a forward FFT per partition of every
+// band, so realtime playback builds designs on LinearPhaseDesignBuilder's thread;
+// the crossover builds in place only when it is prepared and for offline renders.
+class LinearPhaseDesign
+{
+public:
+    // Uniform partitions of the overlap-save convolution
+    static constexpr int kPartitionSize = 256;
+    static constexpr int kBinStride = 2 * (kPartitionSize + 1);    // interleaved complex bins of a 2P point FFT
+
+    // FFTs and scratch for building designs at one sample rate. Each thread that
+    // builds needs its own.
+    class Workspace
+    {
+    public:
+        // Message thread: about 40 ms of FIR, so the lowest crossovers still get
+        // a clean slope
+        void prepare(double sampleRate);
+
+        double getSampleRate() const { return sampleRate; }
+        int getFirLength() const { return firLength; }
+        int getNumPartitions() const { return firLength / kPartitionSize; }
+
+    private:
+        friend class LinearPhaseDesign;
+
+        double sampleRate = 44100.0;
+        int firLength = 0;
+        std::unique_ptr<juce::dsp::FFT> designFft;      // firLength points
+        std::unique_ptr<juce::dsp::FFT> partitionFft;   // 2 * kPartitionSize points
+        std::vector<float> designBuffer;                // 2 * firLength
+        std::vector<float> partitionBuffer;             // 2 * partition FFT size
+    };
+
+    // Message thread: room for kMaxBands at the workspace's sample rate
+    void prepare(const Workspace& workspace);
+
+    // Allocation-free after prepare(). Frequencies are clamped as the crossover
+    // clamps them (CrossoverLayout::getSplitFrequency).
+    void build(Workspace& workspace, int numBands, const CrossoverLayout::Frequencies& frequencies);
+
+    // True if the design holds exactly these settings, or the other design's
+    bool matches(int numBands, const CrossoverLayout::Frequencies& frequencies) const;
+    bool matches(const LinearPhaseDesign& other) const;
+
+    // Takes over another design prepared for the same sample rate, without allocating
+    void copyFrom(const LinearPhaseDesign& other);
+
+    // Zero until the first build
+    int getNumBands() const { return numBands; }
+    int getFirLength() const { return firLength; }
+    int getNumPartitions() const { return numPartitions; }
+
+    const float* getSpectrum(int band, int partition) const
+    {
+        return spectra.data() + (band * numPartitions + partition) * kBinStride;
+    }
+
+private:
+    double sampleRate = 44100.0;
+    int firLength = 0;
+    int numPartitions = 0;
+    int numBands = 0;
+    CrossoverLayout::Frequencies frequencies {};    // clamped, as built
+    std::vector<float> spectra;                     // [(band * numPartitions + partition) * kBinStride]
+};
@@ -0,0 +1,113 @@
+#include "LinearPhaseDesignBuilder.h"
+
+LinearPhaseDesignBuilder::LinearPhaseDesignBuilder()
+    : juce::Thread("Linear phase crossover builder")
+{
+}
+
+LinearPhaseDesignBuilder::~LinearPhaseDesignBuilder()
+{
+    stop();
+}
+
+void LinearPhaseDesignBuilder::prepare(double sampleRate)
+{
+    stop();
+
+    workspace.prepare(sampleRate);
+
+    for (auto& design : designs)
+        design.prepare(workspace);
+
+    activeSlot.store(-1);
+    pendingSlot.store(-1);
+
+    // Anything requested before (or at another sample rate) is built again
+    dirty.store(requested.load());
+}
+
+void LinearPhaseDesignBuilder::start()
+{
+    if (! isThreadRunning())
+        startThread();
+}
+
+void LinearPhaseDesignBuilder::stop()
+{
+    stopThread(1000);
+}
+
+void LinearPhaseDesignBuilder::request(int numBands, const CrossoverLayout::Frequencies& frequencies)
+{
+    // The audio thread requests every block, so unchanged settings return here
+    // without touching the thread's event
+    bool changed = ! requested.load(std::memory_order_relaxed)
+                || requestedNumBands.load(std::memory_order_relaxed) != numBands;
+
+    for (size_t split = 0; split < frequencies.size() && ! changed; ++split)
+        changed = requestedFrequencies[split].load(std::memory_order_relaxed) != frequencies[split];
+
+    if (! changed)
+        return;
+
+    requestedNumBands.store(numBands, std::memory_order_relaxed);
+
+    for (size_t split = 0; split < frequencies.size(); ++split)
+        requestedFrequencies[split].store(frequencies[split], std::memory_order_relaxed);
+
+    requested.store(true, std::memory_order_release);
+    dirty.store(true, std::memory_order_seq_cst);
+    notify();
+}
+
+const LinearPhaseDesign* LinearPhaseDesignBuilder::acquire()
+{
+    const int pending = pendingSlot.load(std::memory_order_acquire);
+
+    if (pending >= 0)
+    {
+        activeSlot.store(pending, std::memory_order_relaxed);
+
+        // Hands the old slot back to the builder, which skipped any newer
+        // request while the slot was taken. Sequentially consistent, so either
+        // this sees that request or the builder sees the free slot.
+        pendingSlot.store(-1, std::memory_order_seq_cst);
+
+        if (dirty.load(std::memory_order_seq_cst))
+            notify();
+    }
+
+    const int active = activeSlot.load(std::memory_order_relaxed);
+    return active >= 0 ? &designs[(size_t) active] : nullptr;
+}
+
+void LinearPhaseDesignBuilder::run()
+{
+    while (! threadShouldExit())
+    {
+        // Wait until the audio thread has taken the last design before reusing
+        // its slot; acquire() wakes the thread again then. The flag is cleared
+        // before reading the settings, so a request landing meanwhile builds again.
+        if (pendingSlot.load(std::memory_order_seq_cst) < 0 && dirty.exchange(false, std::memory_order_seq_cst))
+        {
+            CrossoverLayout::Frequencies frequencies;
+            const int numBands = requestedNumBands.load(std::memory_order_relaxed);
+
+            for (size_t split = 0; split < frequencies.size(); ++split)
+                frequencies[split] = requestedFrequencies[split].load(std::memory_order_relaxed);
+
+            const int active = activeSlot.load(std::memory_order_relaxed);
+
+            if (active < 0 || ! designs[(size_t) active].matches(numBands, frequencies))
+            {
+                const int slot = active == 0 ? 1 : 0;
+                designs[(size_t) slot].build(workspace, numBands, frequencies);
+                pendingSlot.store(slot, std::memory_order_release);
+            }
+        }
+
+        // Until request() or acquire() has more work; a notify() that came
+        // during the build above is not lost
+        wait(-1);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "LinearPhaseDesign.h"
+#include <array>
+#include <atomic>
+
+// Builds LinearPhaseDesigns on a background thread and hands them to the audio
+// thread through a lock-free double buffer, like ShaperTableBuilder.
+//
+// The audio thread reads the active slot. The builder only writes the other
+// slot, and only while no finished design is waiting to be picked up. The
+// crossover copies a design it takes over into its own storage, so the slot is
+// free again once acquire() has returned a newer one.
+//
+// The thread sleeps until request() changes the settings, or until the audio
+// thread picks up a design while a newer request is waiting for its slot.
+class LinearPhaseDesignBuilder : private juce::Thread
+{
+public:
+    LinearPhaseDesignBuilder();
+    ~LinearPhaseDesignBuilder() override;
+
+    // Message thread. prepare() stops the thread, sizes the designs for the
+    // sample rate and drops any built so far.
+    void prepare(double sampleRate);
+    void start();
+    void stop();
+
+    // Any thread
+    bool isRunning() const { return isThreadRunning(); }
+
+    // Any thread: settings the next design should be built for. Wakes the
+    // builder only when they differ from the last request.
+    void request(int numBands, const CrossoverLayout::Frequencies& frequencies);
+
+    // Audio thread: takes a newly published design if there is one and returns
+    // the current design, or nullptr until the first one is ready
+    const LinearPhaseDesign* acquire();
+
+private:
+    void run() override;
+
+    LinearPhaseDesign::Workspace workspace;
+    std::array<LinearPhaseDesign, 2> designs;
+    std::atomic<int> activeSlot { -1 };     // slot the audio thread reads, -1 before the first design
+    std::atomic<int> pendingSlot { -1 };    // finished slot waiting for the audio thread
+
+    std::atomic<bool> requested { false };
+    std::atomic<bool> dirty { false };      // requested settings the builder hasn't looked at yet
+    std::atomic<int> requestedNumBands { CrossoverLayout::kMinBands };
+    std::array<std::atomic<float>, CrossoverLayout::kMaxSplits> requestedFrequencies {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LinearPhaseDesignBuilder)
+};
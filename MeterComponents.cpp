@@ -0,0 +1,142 @@
+#include "MeterComponents.h"
+
+namespace
+{
+    constexpr float kMinDecibels = -60.0f;
+    constexpr float kMaxDecibels = 6.0f;
+
+    // Per update at the editor's 30 Hz timer: peaks fall about 20 dB/s
+    constexpr float kPeakFall = 0.926f;
+    constexpr float kRmsSmoothing = 0.6f;
+}
+
+//==============================================================================
+void LevelMeterComponent::update(const MeteringSource::LevelFrame& frame)
+{
+    if (frame.numBands > 0 && frame.numBands != numBands)
+    {
+        numBands = frame.numBands;
+        repaint();
+    }
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        updateBar(inputBars[(size_t) band], frame.inputRms[(size_t) band], frame.inputPeak[(size_t) band],
+                  getBarBounds(band, false));
+        updateBar(outputBars[(size_t) band], frame.outputRms[(size_t) band], frame.outputPeak[(size_t) band],
+                  getBarBounds(band, true));
+    }
+}
+
+void LevelMeterComponent::updateBar(Bar& bar, float rms, float peak, juce::Rectangle<int> bounds)
+{
+    bar.rms = rms + (bar.rms - rms) * kRmsSmoothing;
+    bar.peak = juce::jmax(peak, bar.peak * kPeakFall);
+
+    const int rmsHeight = levelToHeight(bar.rms, bounds.getHeight());
+    const int peakHeight = levelToHeight(bar.peak, bounds.getHeight());
+
+    // Dirty region: just this bar, and only if something visible changed
+    if (rmsHeight != bar.rmsHeight || peakHeight != bar.peakHeight)
+    {
+        bar.rmsHeight = rmsHeight;
+        bar.peakHeight = peakHeight;
+        repaint(bounds);
+    }
+}
+
+int LevelMeterComponent::levelToHeight(float level, int barHeight) const
+{
+    const float decibels = juce::Decibels::gainToDecibels(level, kMinDecibels);
+    const float proportion = juce::jmap(juce::jlimit(kMinDecibels, kMaxDecibels, decibels),
+                                        kMinDecibels, kMaxDecibels, 0.0f, 1.0f);
+    return juce::roundToInt(proportion * (float) barHeight);
+}
+
+// Bands side by side, each with an input and an output bar
+juce::Rectangle<int> LevelMeterComponent::getBarBounds(int band, bool output) const
+{
+    auto area = getLocalBounds().reduced(4).withTrimmedBottom(16);
+    const int bandWidth = area.getWidth() / juce::jmax(1, numBands);
+    auto bandArea = area.withX(area.getX() + band * bandWidth).withWidth(bandWidth).reduced(4, 0);
+    const int barWidth = bandArea.getWidth() / 2;
+    return output ? bandArea.withTrimmedLeft(barWidth + 1) : bandArea.withWidth(barWidth - 1);
+}
+
+void LevelMeterComponent::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colour(20, 20, 20));
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        for (bool output : { false, true })
+        {
+            const auto bounds = getBarBounds(band, output);
+            const auto& bar = output ? outputBars[(size_t) band] : inputBars[(size_t) band];
+            const auto colour = output ? juce::Colours::orange : juce::Colours::lightgrey;
+
+            g.setColour(juce::Colour(40, 40, 40));
+            g.fillRect(bounds);
+
+            g.setColour(colour.withAlpha(0.7f));
+            g.fillRect(bounds.withTop(bounds.getBottom() - bar.rmsHeight));
+
+            g.setColour(colour);
+            g.fillRect(bounds.withTop(bounds.getBottom() - bar.peakHeight).withHeight(2));
+        }
+
+        g.setColour(juce::Colours::white);
+        g.setFont(12.0f);
+        auto label = getBarBounds(band, false).getUnion(getBarBounds(band, true));
+        g.drawText(juce::String(band + 1), label.withY(label.getBottom()).withHeight(16),
+                   juce::Justification::centred, false);
+    }
+}
+
+//==============================================================================
+void HysteresisScopeComponent::addPoints(const MeteringSource::ScopePoint* newPoints, int numPoints)
+{
+    if (numPoints <= 0)
+        return;
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        points[(size_t) writeIndex] = newPoints[i];
+        writeIndex = (writeIndex + 1) % kDisplayPoints;
+    }
+
+    numStored = juce::jmin(kDisplayPoints, numStored + numPoints);
+    repaint();
+}
+
+void HysteresisScopeComponent::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colour(20, 20, 20));
+
+    const auto area = getLocalBounds().toFloat().reduced(4.0f);
+    const auto centre = area.getCentre();
+
+    g.setColour(juce::Colour(60, 60, 60));
+    g.drawHorizontalLine(juce::roundToInt(centre.y), area.getX(), area.getRight());
+    g.drawVerticalLine(juce::roundToInt(centre.x), area.getY(), area.getBottom());
+
+    if (numStored < 2)
+        return;
+
+    // Both axes span +/-1 (0 dBFS)
+    auto toScreen = [&](const MeteringSource::ScopePoint& p)
+    {
+        return juce::Point<float>(centre.x + juce::jlimit(-1.0f, 1.0f, p.input) * area.getWidth() * 0.5f,
+                                  centre.y - juce::jlimit(-1.0f, 1.0f, p.output) * area.getHeight() * 0.5f);
+    };
+
+    juce::Path path;
+    const int first = (writeIndex - numStored + kDisplayPoints) % kDisplayPoints;
+    path.startNewSubPath(toScreen(points[(size_t) first]));
+
+    for (int i = 1; i < numStored; ++i)
+        path.lineTo(toScreen(points[(size_t) ((first + i) % kDisplayPoints)]));
+
+    g.setColour(juce::Colours::orange);
+    g.strokePath(path, juce::PathStrokeType(1.0f));
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Metering.h"
+
+// Input and output level bars for every band: RMS as a filled bar, peak as a
+// line above it. Only bars whose drawn height changes are repainted.
+class LevelMeterComponent  : public juce::Component
+{
+public:
+    // Applies meter ballistics to a new frame (or an empty one when nothing
+    // arrived) and repaints the bars that moved
+    void update(const MeteringSource::LevelFrame& frame);
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    static constexpr int kMaxBands = MeteringSource::kMaxBands;
+
+    struct Bar
+    {
+        float rms = 0.0f, peak = 0.0f;   // displayed values, linear gain
+        int rmsHeight = 0, peakHeight = 0;
+    };
+
+    juce::Rectangle<int> getBarBounds(int band, bool output) const;
+    int levelToHeight(float level, int barHeight) const;
+    void updateBar(Bar& bar, float rms, float peak, juce::Rectangle<int> bounds);
+
+    std::array<Bar, kMaxBands> inputBars, outputBars;
+    int numBands = CrossoverLayout::kMinBands;
+};
+
+// Dry input against processed output for the recent past. A memoryless curve
+// would draw a single line; the transformer's hysteresis opens it into loops.
+class HysteresisScopeComponent  : public juce::Component
+{
+public:
+    static constexpr int kDisplayPoints = 1024;
+
+    // Appends points and repaints the scope if any arrived
+    void addPoints(const MeteringSource::ScopePoint* points, int numPoints);
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    std::array<MeteringSource::ScopePoint, kDisplayPoints> points {};
+    int writeIndex = 0;
+    int numStored = 0;
+};
@@ -0,0 +1,109 @@
+#include "Metering.h"
+#include <algorithm>
+
+void MeteringSource::setActive(bool shouldBeActive)
+{
+    active.store(shouldBeActive, std::memory_order_relaxed);
+}
+
+void MeteringSource::prepare(double sampleRate)
+{
+    scopeDecimation = juce::jmax(1, juce::roundToInt(sampleRate / kScopeRate));
+    scopePhase = 0;
+}
+
+void MeteringSource::pushLevels(const LevelFrame& frame)
+{
+    int start1, size1, start2, size2;
+    levelFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 > 0)
+        levelFrames[(size_t) start1] = frame;
+
+    levelFifo.finishedWrite(size1);
+}
+
+void MeteringSource::pushScope(const float* input, const float* output, int numSamples)
+{
+    pushScopePoints(input, output, numSamples);
+}
+
+void MeteringSource::pushScope(const double* input, const double* output, int numSamples)
+{
+    pushScopePoints(input, output, numSamples);
+}
+
+template <typename SampleType>
+void MeteringSource::pushScopePoints(const SampleType* input, const SampleType* output, int numSamples)
+{
+    // Decimate first so the write never exceeds a fixed number of points
+    const int numPoints = (numSamples - scopePhase + scopeDecimation - 1) / scopeDecimation;
+
+    if (numPoints <= 0)
+    {
+        scopePhase -= numSamples;
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    scopeFifo.prepareToWrite(numPoints, start1, size1, start2, size2);
+
+    int sample = scopePhase;
+
+    for (int i = 0; i < size1; ++i, sample += scopeDecimation)
+        scopePoints[(size_t) (start1 + i)] = { (float) input[sample], (float) output[sample] };
+
+    for (int i = 0; i < size2; ++i, sample += scopeDecimation)
+        scopePoints[(size_t) (start2 + i)] = { (float) input[sample], (float) output[sample] };
+
+    scopeFifo.finishedWrite(size1 + size2);
+    scopePhase = scopePhase + numPoints * scopeDecimation - numSamples;
+}
+
+bool MeteringSource::popLevels(LevelFrame& frame)
+{
+    const int numReady = levelFifo.getNumReady();
+
+    if (numReady == 0)
+        return false;
+
+    int start1, size1, start2, size2;
+    levelFifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+    LevelFrame held;
+
+    auto hold = [&held](const LevelFrame& next)
+    {
+        for (int band = 0; band < kMaxBands; ++band)
+        {
+            held.inputPeak[(size_t) band] = juce::jmax(held.inputPeak[(size_t) band], next.inputPeak[(size_t) band]);
+            held.outputPeak[(size_t) band] = juce::jmax(held.outputPeak[(size_t) band], next.outputPeak[(size_t) band]);
+        }
+
+        held.numBands = next.numBands;
+        held.inputRms = next.inputRms;
+        held.outputRms = next.outputRms;
+    };
+
+    for (int i = 0; i < size1; ++i)
+        hold(levelFrames[(size_t) (start1 + i)]);
+
+    for (int i = 0; i < size2; ++i)
+        hold(levelFrames[(size_t) (start2 + i)]);
+
+    levelFifo.finishedRead(size1 + size2);
+    frame = held;
+    return true;
+}
+
+int MeteringSource::popScope(ScopePoint* destination, int maxPoints)
+{
+    int start1, size1, start2, size2;
+    scopeFifo.prepareToRead(juce::jmin(maxPoints, scopeFifo.getNumReady()), start1, size1, start2, size2);
+
+    std::copy_n(scopePoints.begin() + start1, size1, destination);
+    std::copy_n(scopePoints.begin() + start2, size2, destination + size1);
+
+    scopeFifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "CrossoverEngine.h"
+#include <array>
+#include <atomic>
+
+// Level and scope data passed from processBlock to the editor.
+//
+// Both streams go through preallocated wait-free single-producer single-consumer
+// FIFOs (juce::AbstractFifo): the audio thread writes, the editor's timer reads.
+// When the FIFOs are full the audio side drops data rather than waiting. While
+// no editor is open isActive() is false and the processor skips all metering.
+class MeteringSource
+{
+public:
+    static constexpr int kMaxBands = CrossoverLayout::kMaxBands;
+    static constexpr int kLevelCapacity = 64;
+    static constexpr int kScopeCapacity = 4096;
+
+    // Scope points are kept at roughly this rate, whatever the sample rate
+    static constexpr double kScopeRate = 12000.0;
+
+    // Peak and RMS of every band before and after the transformer model, for one
+    // processed chunk (the maximum / RMS across channels)
+    struct LevelFrame
+    {
+        int numBands = 0;
+        std::array<float, kMaxBands> inputPeak {}, inputRms {};
+        std::array<float, kMaxBands> outputPeak {}, outputRms {};
+    };
+
+    // Dry input against processed output, for the hysteresis-loop scope
+    struct ScopePoint
+    {
+        float input, output;
+    };
+
+    // Message thread, by the editor
+    void setActive(bool shouldBeActive);
+    bool isActive() const { return active.load(std::memory_order_relaxed); }
+
+    void prepare(double sampleRate);
+
+    // Audio thread
+    void pushLevels(const LevelFrame& frame);
+    void pushScope(const float* input, const float* output, int numSamples);
+    void pushScope(const double* input, const double* output, int numSamples);
+
+    // Message thread: the most recent frame with peaks held over everything
+    // pending, false if nothing arrived
+    bool popLevels(LevelFrame& frame);
+
+    // Message thread: copies up to maxPoints pending points, oldest first
+    int popScope(ScopePoint* destination, int maxPoints);
+
+private:
+    template <typename SampleType>
+    void pushScopePoints(const SampleType* input, const SampleType* output, int numSamples);
+
+    std::atomic<bool> active { false };
+
+    juce::AbstractFifo levelFifo { kLevelCapacity };
+    std::array<LevelFrame, kLevelCapacity> levelFrames;
+
+    juce::AbstractFifo scopeFifo { kScopeCapacity };
+    std::array<ScopePoint, kScopeCapacity> scopePoints;
+    int scopeDecimation = 4;
+    int scopePhase = 0;
+};
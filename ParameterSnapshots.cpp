@@ -0,0 +1,324 @@
+#include "ParameterSnapshots.h"
+#include <cmath>
+#include <limits>
+
+// Every parameter of the processor in host order
+static juce::Array<juce::RangedAudioParameter*> getStateParameters(juce::AudioProcessor& processor)
+{
+    juce::Array<juce::RangedAudioParameter*> result;
+
+    for (auto* parameter : processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            result.add(ranged);
+
+    return result;
+}
+
+ParameterSnapshots::ParameterSnapshots(juce::AudioProcessorValueTreeState& stateToUse)
+    : state(stateToUse)
+{
+}
+
+const ParameterSnapshots::Parameter* ParameterSnapshots::add(const juce::String& parameterID, Morphing morphing)
+{
+    auto entry = std::make_unique<Parameter>();
+    entry->parameter = state.getParameter(parameterID);
+    entry->liveValue = state.getRawParameterValue(parameterID);
+    entry->morphing = morphing;
+    jassert(entry->parameter != nullptr && entry->liveValue != nullptr);
+
+    // Logarithmic morphing needs values above zero
+    jassert(morphing != Morphing::logarithmic || entry->parameter->getNormalisableRange().start > 0.0f);
+
+    for (auto& value : entry->values)
+        value.store(entry->liveValue->load());
+
+    parameters.push_back(std::move(entry));
+    return parameters.back().get();
+}
+
+void ParameterSnapshots::store(int snapshot)
+{
+    if (snapshot < 0 || snapshot >= kNumSnapshots)
+        return;
+
+    for (auto& parameter : parameters)
+        parameter->values[(size_t) snapshot].store(parameter->liveValue->load(), std::memory_order_relaxed);
+
+    storedMask.fetch_or(1 << snapshot, std::memory_order_release);
+}
+
+void ParameterSnapshots::recall(int snapshot)
+{
+    if (! isStored(snapshot))
+        return;
+
+    // One gesture per parameter, so hosts record the recall like a user edit
+    for (auto& parameter : parameters)
+    {
+        auto* ranged = parameter->parameter;
+        ranged->beginChangeGesture();
+        ranged->setValueNotifyingHost(ranged->convertTo0to1(parameter->values[(size_t) snapshot].load(std::memory_order_relaxed)));
+        ranged->endChangeGesture();
+    }
+}
+
+void ParameterSnapshots::clear(int snapshot)
+{
+    if (snapshot >= 0 && snapshot < kNumSnapshots)
+        storedMask.fetch_and(~(1 << snapshot), std::memory_order_release);
+}
+
+bool ParameterSnapshots::isStored(int snapshot) const
+{
+    return snapshot >= 0 && snapshot < kNumSnapshots
+        && (storedMask.load(std::memory_order_acquire) & (1 << snapshot)) != 0;
+}
+
+float ParameterSnapshots::getStoredValue(int snapshot, const Parameter& parameter) const
+{
+    jassert(snapshot >= 0 && snapshot < kNumSnapshots);
+    return parameter.values[(size_t) snapshot].load(std::memory_order_relaxed);
+}
+
+ParameterSnapshots::Morph ParameterSnapshots::getMorph(float x, float y) const
+{
+    Morph morph;
+    const int mask = storedMask.load(std::memory_order_acquire);
+
+    if (mask == 0)
+        return morph;
+
+    x = juce::jlimit(0.0f, 1.0f, x);
+    y = juce::jlimit(0.0f, 1.0f, y);
+
+    const std::array<float, kNumSnapshots> corners { (1.0f - x) * (1.0f - y), x * (1.0f - y), (1.0f - x) * y, x * y };
+    float total = 0.0f;
+
+    for (int snapshot = 0; snapshot < kNumSnapshots; ++snapshot)
+    {
+        if ((mask & (1 << snapshot)) != 0)
+        {
+            morph.weights[(size_t) snapshot] = corners[(size_t) snapshot];
+            total += corners[(size_t) snapshot];
+        }
+    }
+
+    // Sitting on an edge away from every stored corner: the closest one takes over
+    if (total <= 0.0f)
+    {
+        float closest = std::numeric_limits<float>::max();
+
+        for (int snapshot = 0; snapshot < kNumSnapshots; ++snapshot)
+        {
+            const float dx = x - (float) (snapshot & 1);
+            const float dy = y - (float) (snapshot >> 1);
+
+            if ((mask & (1 << snapshot)) != 0 && dx * dx + dy * dy < closest)
+            {
+                closest = dx * dx + dy * dy;
+                morph.nearest = snapshot;
+            }
+        }
+
+        morph.weights[(size_t) morph.nearest] = 1.0f;
+        return morph;
+    }
+
+    float largest = -1.0f;
+
+    for (int snapshot = 0; snapshot < kNumSnapshots; ++snapshot)
+    {
+        morph.weights[(size_t) snapshot] /= total;
+
+        if ((mask & (1 << snapshot)) != 0 && morph.weights[(size_t) snapshot] > largest)
+        {
+            largest = morph.weights[(size_t) snapshot];
+            morph.nearest = snapshot;
+        }
+    }
+
+    return morph;
+}
+
+float ParameterSnapshots::getValue(const Parameter& parameter, const Morph& morph)
+{
+    if (morph.nearest < 0)
+        return parameter.liveValue->load(std::memory_order_relaxed);
+
+    if (parameter.morphing == Morphing::stepped)
+        return parameter.values[(size_t) morph.nearest].load(std::memory_order_relaxed);
+
+    // Snapshots with no weight are skipped, so unstored values never count;
+    // a snapshot at full weight comes back exactly
+    float sum = 0.0f;
+
+    for (size_t snapshot = 0; snapshot < morph.weights.size(); ++snapshot)
+    {
+        const float weight = morph.weights[snapshot];
+
+        if (weight <= 0.0f)
+            continue;
+
+        const float value = parameter.values[snapshot].load(std::memory_order_relaxed);
+        sum += weight * (parameter.morphing == Morphing::logarithmic ? std::log(value) : value);
+    }
+
+    return parameter.morphing == Morphing::logarithmic ? std::exp(sum) : sum;
+}
+
+void ParameterSnapshots::writeState(juce::MemoryBlock& destData) const
+{
+    const auto stateParameters = getStateParameters(state.processor);
+    juce::MemoryOutputStream stream(destData, false);
+
+    stream.writeInt(kStateMagic);
+    stream.writeByte((char) kStateVersion);
+
+    stream.writeCompressedInt(stateParameters.size());
+
+    for (auto* parameter : stateParameters)
+    {
+        stream.writeString(parameter->getParameterID());
+        stream.writeFloat(parameter->convertFrom0to1(parameter->getValue()));
+    }
+
+    stream.writeCompressedInt((int) parameters.size());
+
+    for (auto& parameter : parameters)
+        stream.writeCompressedInt(stateParameters.indexOf(parameter->parameter));
+
+    const int mask = storedMask.load(std::memory_order_acquire);
+    stream.writeByte((char) mask);
+
+    for (int snapshot = 0; snapshot < kNumSnapshots; ++snapshot)
+        if ((mask & (1 << snapshot)) != 0)
+            for (auto& parameter : parameters)
+                stream.writeFloat(parameter->values[(size_t) snapshot].load(std::memory_order_relaxed));
+}
+
+bool ParameterSnapshots::readState(const void* data, int sizeInBytes)
+{
+    juce::MemoryInputStream stream(data, (size_t) juce::jmax(0, sizeInBytes), false);
+
+    if (stream.getNumBytesRemaining() < 5 || stream.readInt() != kStateMagic)
+        return false;
+
+    if ((int) (juce::uint8) stream.readByte() > kStateVersion)
+        return false;
+
+    // Everything is read and checked before anything is applied, so a truncated
+    // or damaged state leaves the plugin as it was. Each value takes at least
+    // five bytes (an empty ID and a float)
+    const int numValues = stream.readCompressedInt();
+
+    if (numValues < 0 || numValues > stream.getNumBytesRemaining() / 5)
+        return false;
+
+    juce::StringArray ids;
+    std::vector<float> values;
+    values.reserve((size_t) numValues);
+
+    for (int i = 0; i < numValues; ++i)
+    {
+        ids.add(stream.readString());
+
+        if (stream.getNumBytesRemaining() < 4)
+            return false;
+
+        values.push_back(stream.readFloat());
+    }
+
+    const int numSnapshotValues = stream.readCompressedInt();
+
+    if (numSnapshotValues < 0 || numSnapshotValues > numValues)
+        return false;
+
+    std::vector<int> positions;
+    positions.reserve((size_t) numSnapshotValues);
+
+    for (int i = 0; i < numSnapshotValues; ++i)
+    {
+        positions.push_back(stream.readCompressedInt());
+
+        if (! juce::isPositiveAndBelow(positions.back(), numValues))
+            return false;
+    }
+
+    if (stream.isExhausted())
+        return false;
+
+    const int mask = (juce::uint8) stream.readByte() & ((1 << kNumSnapshots) - 1);
+    int numStored = 0;
+
+    for (int snapshot = 0; snapshot < kNumSnapshots; ++snapshot)
+        numStored += (mask >> snapshot) & 1;
+
+    if (stream.getNumBytesRemaining() < (juce::int64) numStored * numSnapshotValues * 4)
+        return false;
+
+    std::vector<float> snapshotValues((size_t) (numStored * numSnapshotValues));
+
+    for (auto& value : snapshotValues)
+        value = stream.readFloat();
+
+    // Live values by ID, defaults for anything the state doesn't have. They go
+    // in through the parameter tree's replaceState(), like a restored XML state,
+    // rather than as host automation. Values are stored unnormalised under
+    // "value" in each parameter's "id" child.
+    auto tree = state.copyState();
+
+    for (auto* parameter : getStateParameters(state.processor))
+    {
+        const int index = ids.indexOf(parameter->getParameterID());
+        auto child = tree.getChildWithProperty("id", parameter->getParameterID());
+        jassert(child.isValid());
+
+        child.setProperty("value", index >= 0 ? values[(size_t) index]
+                                              : parameter->convertFrom0to1(parameter->getDefaultValue()), nullptr);
+    }
+
+    state.replaceState(tree);
+
+    // Where each snapshot parameter's value sits in a stored snapshot, -1 if the
+    // state doesn't cover it
+    std::vector<int> sources;
+    sources.reserve(parameters.size());
+
+    for (auto& parameter : parameters)
+    {
+        int source = -1;
+
+        for (int i = 0; i < numSnapshotValues; ++i)
+            if (ids[positions[(size_t) i]] == parameter->parameter->getParameterID())
+                source = i;
+
+        sources.push_back(source);
+    }
+
+    // The audio thread stops morphing while the snapshots are rewritten
+    storedMask.store(0, std::memory_order_release);
+    const float* stored = snapshotValues.data();
+
+    for (int snapshot = 0; snapshot < kNumSnapshots; ++snapshot)
+    {
+        if ((mask & (1 << snapshot)) == 0)
+            continue;
+
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            auto* ranged = parameters[i]->parameter;
+
+            // Uncovered parameters take their restored live value; the rest are
+            // snapped into range the same way a recall would be
+            const float value = sources[i] >= 0 ? stored[sources[i]] : ranged->convertFrom0to1(ranged->getValue());
+            parameters[i]->values[(size_t) snapshot].store(ranged->convertFrom0to1(ranged->convertTo0to1(value)),
+                                                           std::memory_order_relaxed);
+        }
+
+        stored += numSnapshotValues;
+    }
+
+    storedMask.store(mask, std::memory_order_release);
+    return true;
+}
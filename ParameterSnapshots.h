@@ -0,0 +1,94 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// The plugin state in a compact binary format, and four parameter snapshots
+// (A to D) that can be recalled outright or morphed between at block rate.
+//
+// State layout (little endian), version 1:
+//
+//   "LTST" magic, version byte
+//   parameter count, then each parameter's null-terminated UTF-8 ID and float value
+//   snapshot parameter count, then each one's position in the list above
+//   stored-snapshot mask byte, then for each stored snapshot a float per snapshot parameter
+//
+// Counts and positions are JUCE compressed ints. Values are matched by ID on
+// load, so states keep working as parameters are added or reordered; parameters
+// a state doesn't mention go back to their defaults.
+//
+// Snapshot values live in atomics: the message thread stores and recalls them
+// while the audio thread reads them for the morph, without locks. A morph that
+// catches a store halfway mixes old and new values for one block, which the
+// engine's smoothing hides.
+class ParameterSnapshots
+{
+public:
+    static constexpr int kNumSnapshots = 4;
+    static constexpr int kStateVersion = 1;
+
+    // How a parameter gets from one snapshot's value to another's while morphing
+    enum class Morphing
+    {
+        linear,
+        logarithmic,    // frequencies, times and drives; the range must start above zero
+        stepped         // choices: the value of the nearest snapshot
+    };
+
+    // A parameter included in the snapshots
+    struct Parameter
+    {
+        juce::RangedAudioParameter* parameter = nullptr;
+        std::atomic<float>* liveValue = nullptr;
+        Morphing morphing = Morphing::linear;
+        std::array<std::atomic<float>, kNumSnapshots> values {};
+    };
+
+    // Where a morph sits: each snapshot's weight, normalised over the stored ones
+    struct Morph
+    {
+        std::array<float, kNumSnapshots> weights {};
+        int nearest = -1; // snapshot with the largest weight; -1 follows the live values
+    };
+
+    explicit ParameterSnapshots(juce::AudioProcessorValueTreeState& state);
+
+    // Construction only: includes a parameter in the snapshots and returns the
+    // handle its value is read through
+    const Parameter* add(const juce::String& parameterID, Morphing morphing);
+
+    // Message thread. Recalling sets the parameters inside change gestures,
+    // notifying the host, so the engine's smoothers carry the change
+    void store(int snapshot);
+    void recall(int snapshot);
+    void clear(int snapshot);
+    bool isStored(int snapshot) const;
+    float getStoredValue(int snapshot, const Parameter& parameter) const;
+
+    // Audio thread: bilinear weights for a position in 0..1, with A at (0, 0),
+    // B at (1, 0), C at (0, 1) and D at (1, 1). Corners without a snapshot drop
+    // out; with none stored the morph follows the live values
+    Morph getMorph(float x, float y) const;
+
+    // The parameter's value at the morph, or its live value
+    static float getValue(const Parameter& parameter, const Morph& morph);
+
+    // Message thread: every parameter of the state plus the stored snapshots
+    void writeState(juce::MemoryBlock& destData) const;
+
+    // Restores what writeState() wrote, setting the parameters through the value
+    // tree rather than as automation. Returns false, touching nothing, if the
+    // data isn't in this format or is from a newer version
+    bool readState(const void* data, int sizeInBytes);
+
+private:
+    static constexpr int kStateMagic = 0x5453544c; // "LTST"
+
+    juce::AudioProcessorValueTreeState& state;
+    std::vector<std::unique_ptr<Parameter>> parameters;
+    std::atomic<int> storedMask { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (ParameterSnapshots)
+};
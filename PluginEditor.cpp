@@ -6,7 +6,7 @@
 TransformerAudioProcessorEditor::TransformerAudioProcessorEditor (TransformerAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
-    setSize (600, 400);
+    setSize (600 + kMeterPanelWidth, 508 + kSidechainRowHeight + kSnapshotRowHeight);
     
     // Initialize all sliders with rotary style
     auto setupSlider = [this](juce::Slider& slider, juce::Label& label, const juce::String& labelText)
@@ -39,6 +39,71 @@ TransformerAudioProcessorEditor::TransformerAudioProcessorEditor (TransformerAud
     setupSlider(hysteresisSlider, hysteresisLabel, "Hysteresis");
     setupSlider(asymmetrySlider, asymmetryLabel, "Asymmetry");
     
+    // Choice parameters; items must exist before the attachments are created
+    auto setupComboBox = [this](juce::ComboBox& box, juce::Label& label,
+                                const juce::String& parameterID, const juce::String& labelText)
+    {
+        if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.parameters.getParameter(parameterID)))
+            box.addItemList(choice->choices, 1);
+        
+        label.setText(labelText, juce::dontSendNotification);
+        label.setJustificationType(juce::Justification::centredRight);
+        label.attachToComponent(&box, true);
+        
+        addAndMakeVisible(box);
+        addAndMakeVisible(label);
+    };
+    
+    setupComboBox(oversamplingBox, oversamplingLabel, "oversampling", "Oversampling");
+    setupComboBox(renderQualityBox, renderQualityLabel, "renderQuality", "Render");
+    setupComboBox(numBandsBox, numBandsLabel, "numBands", "Bands");
+    setupComboBox(crossoverModeBox, crossoverModeLabel, "crossoverMode", "Crossover");
+    setupComboBox(hysteresisModelBox, hysteresisModelLabel, "hysteresisModel", "Model");
+    setupComboBox(preisachResolutionBox, preisachResolutionLabel, "preisachResolution", "Resolution");
+    setupComboBox(sidechainModeBox, sidechainModeLabel, "sidechainMode", "Sidechain");
+    
+    // Depth is bipolar (negative ducks), so a horizontal slider reads better than a knob
+    sidechainDepthSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    sidechainDepthSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 20);
+    sidechainDepthSlider.setColour(juce::Slider::thumbColourId, juce::Colours::orangered);
+    sidechainDepthLabel.setText("Depth", juce::dontSendNotification);
+    sidechainDepthLabel.setJustificationType(juce::Justification::centredRight);
+    sidechainDepthLabel.attachToComponent(&sidechainDepthSlider, true);
+    addAndMakeVisible(sidechainDepthSlider);
+    addAndMakeVisible(sidechainDepthLabel);
+    
+    // Snapshot buttons light up once stored (see timerCallback)
+    storeSnapshotButton.setClickingTogglesState(true);
+    storeSnapshotButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::orangered);
+    addAndMakeVisible(storeSnapshotButton);
+    
+    for (int snapshot = 0; snapshot < (int) snapshotButtons.size(); ++snapshot)
+    {
+        auto& button = snapshotButtons[(size_t) snapshot];
+        button.setButtonText(juce::String::charToString((juce::juce_wchar) ('A' + snapshot)));
+        button.setColour(juce::TextButton::buttonOnColourId, juce::Colours::orange.darker());
+        button.onClick = [this, snapshot] { snapshotClicked(snapshot); };
+        addAndMakeVisible(button);
+    }
+    
+    // X runs from A/C to B/D, Y from A/B to C/D
+    auto setupMorphSlider = [this](juce::Slider& slider, juce::Label& label, const juce::String& labelText)
+    {
+        slider.setSliderStyle(juce::Slider::LinearHorizontal);
+        slider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+        slider.setColour(juce::Slider::thumbColourId, juce::Colours::orangered);
+        label.setText(labelText, juce::dontSendNotification);
+        label.setJustificationType(juce::Justification::centredRight);
+        label.attachToComponent(&slider, true);
+        addAndMakeVisible(slider);
+        addAndMakeVisible(label);
+    };
+    
+    setupMorphSlider(morphXSlider, morphXLabel, "X");
+    setupMorphSlider(morphYSlider, morphYLabel, "Y");
+    
+    addAndMakeVisible(snapshotMorphButton);
+    
     // Parameter attachments
     driveAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(
         audioProcessor.parameters, "drive", driveSlider));
@@ -57,9 +122,144 @@ TransformerAudioProcessorEditor::TransformerAudioProcessorEditor (TransformerAud
     
     asymmetryAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(
         audioProcessor.parameters, "asymmetry", asymmetrySlider));
+    
+    oversamplingAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(
+        audioProcessor.parameters, "oversampling", oversamplingBox));
+    
+    renderQualityAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(
+        audioProcessor.parameters, "renderQuality", renderQualityBox));
+    
+    numBandsAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(
+        audioProcessor.parameters, "numBands", numBandsBox));
+    
+    crossoverModeAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(
+        audioProcessor.parameters, "crossoverMode", crossoverModeBox));
+    
+    hysteresisModelAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(
+        audioProcessor.parameters, "hysteresisModel", hysteresisModelBox));
+    
+    preisachResolutionAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(
+        audioProcessor.parameters, "preisachResolution", preisachResolutionBox));
+    
+    sidechainModeAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(
+        audioProcessor.parameters, "sidechainMode", sidechainModeBox));
+    
+    sidechainDepthAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(
+        audioProcessor.parameters, "sidechainDepth", sidechainDepthSlider));
+    
+    snapshotMorphAttachment.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(
+        audioProcessor.parameters, "snapshotMorph", snapshotMorphButton));
+    
+    morphXAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(
+        audioProcessor.parameters, "morphX", morphXSlider));
+    
+    morphYAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(
+        audioProcessor.parameters, "morphY", morphYSlider));
+    
+    // The processor only meters while an editor is listening
+    addAndMakeVisible(levelMeter);
+    addAndMakeVisible(hysteresisScope);
+    
+   #if TRANSFORMER_PROFILE_STAGES
+    stageProfileLabel.setFont(juce::Font(11.0f));
+    stageProfileLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    stageProfileLabel.setJustificationType(juce::Justification::topLeft);
+    saveStageProfileButton.onClick = [this] { saveStageProfile(); };
+    addAndMakeVisible(stageProfileLabel);
+    addAndMakeVisible(saveStageProfileButton);
+   #endif
+    
+    audioProcessor.getMetering().setActive(true);
+    startTimerHz(30);
+}
+
+TransformerAudioProcessorEditor::~TransformerAudioProcessorEditor()
+{
+    stopTimer();
+    audioProcessor.getMetering().setActive(false);
 }
 
-TransformerAudioProcessorEditor::~TransformerAudioProcessorEditor() { }
+void TransformerAudioProcessorEditor::timerCallback()
+{
+    auto& metering = audioProcessor.getMetering();
+    
+    // With nothing new the meters still fall back
+    MeteringSource::LevelFrame levels;
+    metering.popLevels(levels);
+    levelMeter.update(levels);
+    
+    const int numPoints = metering.popScope(scopeScratch.data(), (int) scopeScratch.size());
+    hysteresisScope.addPoints(scopeScratch.data(), numPoints);
+    
+    for (int snapshot = 0; snapshot < (int) snapshotButtons.size(); ++snapshot)
+        snapshotButtons[(size_t) snapshot].setToggleState(audioProcessor.isSnapshotStored(snapshot), juce::dontSendNotification);
+    
+   #if TRANSFORMER_PROFILE_STAGES
+    if (--stageProfileCountdown <= 0)
+    {
+        stageProfileCountdown = 15;
+        updateStageProfile();
+    }
+   #endif
+}
+
+void TransformerAudioProcessorEditor::snapshotClicked(int snapshot)
+{
+    if (juce::ModifierKeys::currentModifiers.isAltDown())
+    {
+        audioProcessor.clearSnapshot(snapshot);
+    }
+    else if (storeSnapshotButton.getToggleState())
+    {
+        audioProcessor.storeSnapshot(snapshot);
+        storeSnapshotButton.setToggleState(false, juce::dontSendNotification);
+    }
+    else
+    {
+        audioProcessor.recallSnapshot(snapshot);
+    }
+    
+    snapshotButtons[(size_t) snapshot].setToggleState(audioProcessor.isSnapshotStored(snapshot), juce::dontSendNotification);
+}
+
+#if TRANSFORMER_PROFILE_STAGES
+void TransformerAudioProcessorEditor::updateStageProfile()
+{
+    const auto& profiler = audioProcessor.getStageProfiler();
+    const double microsecondsPerTick = 1.0e6 / StageProfiler::getCounterFrequency();
+    juce::StringArray stages;
+    
+    for (int i = 0; i < StageProfiler::kNumStages; ++i)
+    {
+        const auto stage = (StageProfiler::Stage) i;
+        const auto histogram = profiler.getHistogram(stage);
+        
+        if (histogram.count > 0)
+            stages.add(juce::String(StageProfiler::getStageName(stage)) + " "
+                       + juce::String(histogram.getMeanTicks() * microsecondsPerTick, 1));
+    }
+    
+    stageProfileLabel.setText(stages.isEmpty() ? juce::String("no timings yet")
+                                               : "us/call: " + stages.joinIntoString("  "),
+                              juce::dontSendNotification);
+}
+
+void TransformerAudioProcessorEditor::saveStageProfile()
+{
+    stageProfileChooser = std::make_unique<juce::FileChooser>(
+        "Save stage timings", juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                                  .getChildFile("transformer-stages.json"), "*.json");
+    
+    stageProfileChooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles,
+                                     [this](const juce::FileChooser& chooser)
+    {
+        const auto file = chooser.getResult();
+        
+        if (file != juce::File())
+            file.replaceWithText(audioProcessor.getStageProfiler().toJson());
+    });
+}
+#endif
 
 void TransformerAudioProcessorEditor::paint (juce::Graphics& g)
 {
@@ -75,25 +275,84 @@ void TransformerAudioProcessorEditor::paint (juce::Graphics& g)
     g.drawText("Lovely Transformer", getLocalBounds().reduced(10).removeFromTop(30), 
               juce::Justification::centred, true);
     
-    // Draw section dividers
+    // Draw section dividers within the controls area; the sidechain and snapshot
+    // rows leave the sections above them where they were
+    const int controlsWidth = getWidth() - kMeterPanelWidth;
+    const int extraRowsHeight = kSidechainRowHeight + kSnapshotRowHeight;
+    const float sectionSplit = (getHeight() - extraRowsHeight) / 2.0f;
     g.setColour(juce::Colours::grey);
-    g.drawLine(getWidth() / 2.0f, 60, getWidth() / 2.0f, getHeight() - 20, 1.0f);
-    g.drawLine(0, getHeight() / 2.0f, getWidth(), getHeight() / 2.0f, 1.0f);
+    g.drawLine(controlsWidth / 2.0f, 60, controlsWidth / 2.0f, getHeight() - 128.0f - extraRowsHeight, 1.0f);
+    g.drawLine(0, sectionSplit, (float) controlsWidth, sectionSplit, 1.0f);
+    g.drawLine((float) controlsWidth, 60, (float) controlsWidth, getHeight() - 20.0f, 1.0f);
     
     // Section labels
     g.setFont(16.0f);
     g.setColour(juce::Colours::white);
-    g.drawText("I/O", 10, 40, getWidth() / 2 - 20, 20, juce::Justification::left);
-    g.drawText("Harmonics", getWidth() / 2 + 10, 40, getWidth() / 2 - 20, 20, juce::Justification::left);
-    g.drawText("Transformer", 10, getHeight() / 2 - 10, getWidth() - 20, 20, juce::Justification::left);
+    g.drawText("I/O", 10, 40, controlsWidth / 2 - 20, 20, juce::Justification::left);
+    g.drawText("Harmonics", controlsWidth / 2 + 10, 40, controlsWidth / 2 - 20, 20, juce::Justification::left);
+    g.drawText("Transformer", 10, (int) sectionSplit - 10, controlsWidth - 20, 20, juce::Justification::left);
+    g.drawText("Bands In / Out", controlsWidth + 10, 40, kMeterPanelWidth - 20, 20, juce::Justification::left);
+    g.drawText("Hysteresis Loop", controlsWidth + 10, 270, kMeterPanelWidth - 20, 20, juce::Justification::left);
 }
 
 void TransformerAudioProcessorEditor::resized()
 {
+    // Metering panel down the right-hand side
+    auto area = getLocalBounds();
+    auto meterPanel = area.removeFromRight(kMeterPanelWidth).reduced(10, 0);
+    levelMeter.setBounds(meterPanel.withTop(62).withHeight(200));
+    hysteresisScope.setBounds(meterPanel.withTop(292).withHeight(meterPanel.getWidth()).withSizeKeepingCentre(196, 196));
+    
+   #if TRANSFORMER_PROFILE_STAGES
+    stageProfileLabel.setBounds(meterPanel.withTop(hysteresisScope.getBottom() + 2).withHeight(22));
+    saveStageProfileButton.setBounds(meterPanel.withTop(stageProfileLabel.getBottom()).withHeight(16).removeFromRight(100));
+   #endif
+    
     // Define areas for each section
-    auto bounds = getLocalBounds().reduced(20);
+    auto bounds = area.reduced(20);
     bounds.removeFromTop(40); // Space for title
     
+    // Snapshots and the morph along the bottom, sidechain modulation above them,
+    // then the quality options with the crossover and hysteresis model options
+    // above those; labels sit to the left
+    auto snapshotRow = bounds.removeFromBottom(24);
+    bounds.removeFromBottom(10);
+    auto snapshotLeft = snapshotRow.removeFromLeft(snapshotRow.getWidth() / 2);
+    storeSnapshotButton.setBounds(snapshotLeft.removeFromLeft(60));
+    snapshotLeft.removeFromLeft(10);
+    
+    for (auto& button : snapshotButtons)
+        button.setBounds(snapshotLeft.removeFromLeft(snapshotLeft.getHeight() + 14).reduced(2, 0));
+    
+    snapshotMorphButton.setBounds(snapshotRow.removeFromLeft(70));
+    auto morphXArea = snapshotRow.removeFromLeft(snapshotRow.getWidth() / 2);
+    morphXSlider.setBounds(morphXArea.withTrimmedLeft(20));
+    morphYSlider.setBounds(snapshotRow.withTrimmedLeft(20));
+    
+    auto sidechainRow = bounds.removeFromBottom(24);
+    bounds.removeFromBottom(10);
+    auto sidechainLeft = sidechainRow.removeFromLeft(sidechainRow.getWidth() / 2);
+    sidechainModeBox.setBounds(sidechainLeft.removeFromRight(150));
+    sidechainDepthSlider.setBounds(sidechainRow.removeFromRight(200));
+    
+    auto optionsRow = bounds.removeFromBottom(24);
+    bounds.removeFromBottom(10);
+    auto optionsLeft = optionsRow.removeFromLeft(optionsRow.getWidth() / 2);
+    oversamplingBox.setBounds(optionsLeft.removeFromRight(150));
+    renderQualityBox.setBounds(optionsRow.removeFromRight(150));
+    
+    auto crossoverRow = bounds.removeFromBottom(24);
+    bounds.removeFromBottom(10);
+    auto crossoverLeft = crossoverRow.removeFromLeft(crossoverRow.getWidth() / 2);
+    numBandsBox.setBounds(crossoverLeft.removeFromRight(150));
+    crossoverModeBox.setBounds(crossoverRow.removeFromRight(150));
+    
+    auto modelRow = bounds.removeFromBottom(24);
+    bounds.removeFromBottom(10);
+    auto modelLeft = modelRow.removeFromLeft(modelRow.getWidth() / 2);
+    hysteresisModelBox.setBounds(modelLeft.removeFromRight(150));
+    preisachResolutionBox.setBounds(modelRow.removeFromRight(150));
+    
     auto topHalf = bounds.removeFromTop(bounds.getHeight() / 2 - 10);
     auto bottomHalf = bounds;
     
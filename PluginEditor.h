@@ -2,7 +2,9 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "PluginProcessor.h"
-class TransformerAudioProcessorEditor  : public juce::AudioProcessorEditor
+#include "MeterComponents.h"
+class TransformerAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                         private juce::Timer
 {
 public:
     TransformerAudioProcessorEditor (TransformerAudioProcessor&);
@@ -10,6 +12,25 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 private:
+    // Drains the metering FIFOs into the meters and the scope
+    void timerCallback() override;
+    
+   #if TRANSFORMER_PROFILE_STAGES
+    // Mean microseconds per call of every stage, and a JSON dump of the histograms
+    void updateStageProfile();
+    void saveStageProfile();
+   #endif
+    
+    // Controls on the left, metering panel on the right
+    static constexpr int kMeterPanelWidth = 240;
+    
+    // Sidechain controls sit in their own row below the options, snapshots below that
+    static constexpr int kSidechainRowHeight = 34;
+    static constexpr int kSnapshotRowHeight = 34;
+    
+    // Recalls the snapshot, stores it while Store is down, clears it on alt-click
+    void snapshotClicked(int snapshot);
+    
     TransformerAudioProcessor& audioProcessor;
     
     // Core controls
@@ -32,6 +53,39 @@ private:
     juce::Label hysteresisLabel;
     juce::Label asymmetryLabel;
     
+    // Quality options
+    juce::ComboBox oversamplingBox;
+    juce::ComboBox renderQualityBox;
+    juce::Label oversamplingLabel;
+    juce::Label renderQualityLabel;
+    
+    // Crossover options
+    juce::ComboBox numBandsBox;
+    juce::ComboBox crossoverModeBox;
+    juce::Label numBandsLabel;
+    juce::Label crossoverModeLabel;
+    
+    // Hysteresis model options
+    juce::ComboBox hysteresisModelBox;
+    juce::ComboBox preisachResolutionBox;
+    juce::Label hysteresisModelLabel;
+    juce::Label preisachResolutionLabel;
+    
+    // Sidechain drive modulation
+    juce::ComboBox sidechainModeBox;
+    juce::Slider sidechainDepthSlider;
+    juce::Label sidechainModeLabel;
+    juce::Label sidechainDepthLabel;
+    
+    // Snapshots A-D and the morph between them
+    juce::TextButton storeSnapshotButton { "Store" };
+    std::array<juce::TextButton, ParameterSnapshots::kNumSnapshots> snapshotButtons;
+    juce::ToggleButton snapshotMorphButton { "Morph" };
+    juce::Slider morphXSlider;
+    juce::Slider morphYSlider;
+    juce::Label morphXLabel;
+    juce::Label morphYLabel;
+    
     // Parameter attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> driveAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gainAttachment;
@@ -39,6 +93,30 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> oddHarmonicsAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> hysteresisAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> asymmetryAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> renderQualityAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> numBandsAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> crossoverModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> hysteresisModelAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> preisachResolutionAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> sidechainModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> sidechainDepthAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> snapshotMorphAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> morphXAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> morphYAttachment;
+    
+    // Metering
+    LevelMeterComponent levelMeter;
+    HysteresisScopeComponent hysteresisScope;
+    std::array<MeteringSource::ScopePoint, MeteringSource::kScopeCapacity> scopeScratch;
+    
+   #if TRANSFORMER_PROFILE_STAGES
+    // Stage timings under the scope, refreshed twice a second
+    juce::Label stageProfileLabel;
+    juce::TextButton saveStageProfileButton { "Save timings..." };
+    std::unique_ptr<juce::FileChooser> stageProfileChooser;
+    int stageProfileCountdown = 0;
+   #endif
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransformerAudioProcessorEditor)
 };
@@ -1,61 +1,215 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "RealtimeAllocationGuard.h"
 #include <cmath>
 
+// Every parameter the processor reads; the crossover and per-band drive
+// parameters are generated for the largest band count
+static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout
+    {
+        std::make_unique<juce::AudioParameterFloat>(
+            "drive",                     // parameterID
+            "Drive",                     // parameter name
+            juce::NormalisableRange<float>(0.1f, 10.0f, 0.1f), // range
+            1.0f                         // default value
+        ),
+        std::make_unique<juce::AudioParameterFloat>(
+            "outputGain",                // parameterID
+            "Output Gain",               // parameter name
+            juce::NormalisableRange<float>(0.0f, 2.0f, 0.01f), // range
+            1.0f                         // default value
+        ),
+        std::make_unique<juce::AudioParameterFloat>(
+            "evenHarmonics",             // parameterID
+            "Even Harmonics",            // parameter name
+            juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), // range
+            0.3f                         // default value
+        ),
+        std::make_unique<juce::AudioParameterFloat>(
+            "oddHarmonics",              // parameterID
+            "Odd Harmonics",             // parameter name
+            juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), // range
+            1.0f                         // default value
+        ),
+        std::make_unique<juce::AudioParameterFloat>(
+            "hysteresis",                // parameterID
+            "Hysteresis",                // parameter name
+            juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), // range
+            0.2f                         // default value
+        ),
+        std::make_unique<juce::AudioParameterFloat>(
+            "asymmetry",                 // parameterID
+            "Asymmetry",                 // parameter name
+            juce::NormalisableRange<float>(-0.5f, 0.5f, 0.01f), // range
+            0.1f                         // default value
+        ),
+        std::make_unique<juce::AudioParameterChoice>(
+            "oversampling",              // parameterID
+            "Oversampling",              // parameter name
+            juce::StringArray { "Off", "2x", "4x", "8x" }, // choices
+            1                            // default index (2x)
+        ),
+        std::make_unique<juce::AudioParameterChoice>(
+            "renderQuality",             // parameterID
+            "Render Quality",            // parameter name
+            juce::StringArray { "Same as Realtime", "2x", "4x", "8x" }, // oversampling for offline bounces
+            3                            // default index (8x)
+        ),
+        std::make_unique<juce::AudioParameterChoice>(
+            "numBands",                  // parameterID
+            "Bands",                     // parameter name
+            juce::StringArray { "2", "3", "4", "5" }, // choices
+            0                            // default index (2 bands)
+        ),
+        std::make_unique<juce::AudioParameterChoice>(
+            "crossoverMode",             // parameterID
+            "Crossover",                 // parameter name
+            juce::StringArray { "Linkwitz-Riley", "Linear Phase" }, // choices
+            0                            // default index (Linkwitz-Riley)
+        ),
+        std::make_unique<juce::AudioParameterChoice>(
+            "hysteresisModel",           // parameterID
+            "Hysteresis Model",          // parameter name
+            juce::StringArray { "Decay", "Preisach" }, // choices
+            0                            // default index (Decay)
+        ),
+        std::make_unique<juce::AudioParameterChoice>(
+            "preisachResolution",        // parameterID
+            "Preisach Resolution",       // parameter name
+            juce::StringArray { "32", "64", "128", "256" }, // hysteron grid cells per axis
+            1                            // default index (64)
+        ),
+        std::make_unique<juce::AudioParameterChoice>(
+            "shaper",                    // parameterID
+            "Shaper",                    // parameter name
+            juce::StringArray { "Exact", "Table (Linear)", "Table (Cubic)" }, // choices
+            0                            // default index (Exact)
+        ),
+        std::make_unique<juce::AudioParameterChoice>(
+            "sidechainMode",             // parameterID
+            "Sidechain",                 // parameter name
+            juce::StringArray { "Off", "Direct", "Envelope" }, // drive modulation source
+            0                            // default index (Off)
+        ),
+        std::make_unique<juce::AudioParameterFloat>(
+            "sidechainDepth",            // parameterID
+            "Sidechain Depth",           // parameter name
+            juce::NormalisableRange<float>(-1.0f, 1.0f, 0.01f), // negative depth ducks the drive
+            0.0f                         // default value
+        ),
+        std::make_unique<juce::AudioParameterFloat>(
+            "sidechainAttack",           // parameterID
+            "Sidechain Attack",          // parameter name
+            juce::NormalisableRange<float>(0.1f, 100.0f, 0.1f, 0.5f), // ms
+            5.0f                         // default value
+        ),
+        std::make_unique<juce::AudioParameterFloat>(
+            "sidechainRelease",          // parameterID
+            "Sidechain Release",         // parameter name
+            juce::NormalisableRange<float>(5.0f, 2000.0f, 1.0f, 0.5f), // ms
+            100.0f                       // default value
+        ),
+        std::make_unique<juce::AudioParameterBool>(
+            "snapshotMorph",             // parameterID
+            "Snapshot Morph",            // parameter name
+            false                        // default value
+        ),
+        std::make_unique<juce::AudioParameterFloat>(
+            "morphX",                    // parameterID
+            "Morph X",                   // parameter name
+            juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), // A/C at 0, B/D at 1
+            0.0f                         // default value
+        ),
+        std::make_unique<juce::AudioParameterFloat>(
+            "morphY",                    // parameterID
+            "Morph Y",                   // parameter name
+            juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), // A/B at 0, C/D at 1
+            0.0f                         // default value
+        )
+    };
+    
+    // Split frequencies, ascending; splits beyond the band count are ignored
+    const float defaultFrequencies[] = { 1000.0f, 4000.0f, 8000.0f, 12000.0f };
+    
+    for (int split = 0; split < CrossoverLayout::kMaxSplits; ++split)
+    {
+        juce::NormalisableRange<float> range(20.0f, 20000.0f, 1.0f);
+        range.setSkewForCentre(1000.0f);
+        
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            "crossover" + juce::String(split + 1),
+            "Crossover " + juce::String(split + 1),
+            range,
+            defaultFrequencies[split]));
+    }
+    
+    // Lows get more intense saturation by default (transformers affect lows more)
+    const float defaultBandDrives[] = { 1.5f, 0.5f, 0.5f, 0.5f, 0.5f };
+    
+    for (int band = 0; band < CrossoverLayout::kMaxBands; ++band)
+    {
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            "bandDrive" + juce::String(band + 1),
+            "Band " + juce::String(band + 1) + " Drive",
+            juce::NormalisableRange<float>(0.0f, 3.0f, 0.01f),
+            defaultBandDrives[band]));
+    }
+    
+    return layout;
+}
+
 TransformerAudioProcessor::TransformerAudioProcessor()
     : AudioProcessor(BusesProperties()
           .withInput("Input", juce::AudioChannelSet::stereo(), true)
-          .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
-      parameters(*this, nullptr, "Parameters",
-      {
-          std::make_unique<juce::AudioParameterFloat>(
-              "drive",                     // parameterID
-              "Drive",                     // parameter name
-              juce::NormalisableRange<float>(0.1f, 10.0f, 0.1f), // range
-              1.0f                         // default value
-          ),
-          std::make_unique<juce::AudioParameterFloat>(
-              "outputGain",                // parameterID
-              "Output Gain",               // parameter name
-              juce::NormalisableRange<float>(0.0f, 2.0f, 0.01f), // range
-              1.0f                         // default value
-          ),
-          std::make_unique<juce::AudioParameterFloat>(
-              "evenHarmonics",             // parameterID
-              "Even Harmonics",            // parameter name
-              juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), // range
-              0.3f                         // default value
-          ),
-          std::make_unique<juce::AudioParameterFloat>(
-              "oddHarmonics",              // parameterID
-              "Odd Harmonics",             // parameter name
-              juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), // range
-              1.0f                         // default value
-          ),
-          std::make_unique<juce::AudioParameterFloat>(
-              "hysteresis",                // parameterID
-              "Hysteresis",                // parameter name
-              juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), // range
-              0.2f                         // default value
-          ),
-          std::make_unique<juce::AudioParameterFloat>(
-              "asymmetry",                 // parameterID
-              "Asymmetry",                 // parameter name
-              juce::NormalisableRange<float>(-0.5f, 0.5f, 0.01f), // range
-              0.1f                         // default value
-          )
-      })
-{
-    // Initialize transformer models with default settings
-    transformerModelL.setDensityParams(0.2f, 0.1f);
-    transformerModelL.setHarmonics(0.3f, 1.0f);
-    
-    transformerModelR.setDensityParams(0.2f, 0.1f);
-    transformerModelR.setHarmonics(0.3f, 1.0f);
+          .withOutput("Output", juce::AudioChannelSet::stereo(), true)
+          .withInput("Sidechain", juce::AudioChannelSet::stereo(), false)),
+      parameters(*this, nullptr, "Parameters", createParameterLayout())
+{
+    // Look the parameters up once; processBlock only reads the atomics. Drives,
+    // frequencies and times morph on a log scale, choices step
+    using Morphing = ParameterSnapshots::Morphing;
+    driveParameter = snapshots.add("drive", Morphing::logarithmic);
+    outputGainParameter = snapshots.add("outputGain", Morphing::linear);
+    evenHarmonicsParameter = snapshots.add("evenHarmonics", Morphing::linear);
+    oddHarmonicsParameter = snapshots.add("oddHarmonics", Morphing::linear);
+    hysteresisParameter = snapshots.add("hysteresis", Morphing::linear);
+    asymmetryParameter = snapshots.add("asymmetry", Morphing::linear);
+    numBandsParameter = snapshots.add("numBands", Morphing::stepped);
+    hysteresisModelParameter = snapshots.add("hysteresisModel", Morphing::stepped);
+    sidechainModeParameter = snapshots.add("sidechainMode", Morphing::stepped);
+    sidechainDepthParameter = snapshots.add("sidechainDepth", Morphing::linear);
+    sidechainAttackParameter = snapshots.add("sidechainAttack", Morphing::logarithmic);
+    sidechainReleaseParameter = snapshots.add("sidechainRelease", Morphing::logarithmic);
+    
+    for (size_t split = 0; split < crossoverParameters.size(); ++split)
+        crossoverParameters[split] = snapshots.add("crossover" + juce::String((int) split + 1), Morphing::logarithmic);
+    
+    for (size_t band = 0; band < bandDriveParameters.size(); ++band)
+        bandDriveParameters[band] = snapshots.add("bandDrive" + juce::String((int) band + 1), Morphing::linear);
+    
+    oversamplingParameter = parameters.getRawParameterValue("oversampling");
+    renderQualityParameter = parameters.getRawParameterValue("renderQuality");
+    crossoverModeParameter = parameters.getRawParameterValue("crossoverMode");
+    preisachResolutionParameter = parameters.getRawParameterValue("preisachResolution");
+    shaperParameter = parameters.getRawParameterValue("shaper");
+    snapshotMorphParameter = parameters.getRawParameterValue("snapshotMorph");
+    morphXParameter = parameters.getRawParameterValue("morphX");
+    morphYParameter = parameters.getRawParameterValue("morphY");
+    
+    floatEngine.setProfiler(&stageProfiler);
+    doubleEngine.setProfiler(&stageProfiler);
+    
+    startTimer(kTimerIntervalMs);
 }
 
 TransformerAudioProcessor::~TransformerAudioProcessor()
 {
+    stopTimer();
+    shaperTableBuilder.stop();
+    everettTableBuilder.stop();
+    crossoverDesignBuilder.stop();
 }
 
 const juce::String TransformerAudioProcessor::getName() const
@@ -66,7 +220,12 @@ const juce::String TransformerAudioProcessor::getName() const
 bool TransformerAudioProcessor::acceptsMidi() const { return false; }
 bool TransformerAudioProcessor::producesMidi() const { return false; }
 bool TransformerAudioProcessor::isMidiEffect() const { return false; }
-double TransformerAudioProcessor::getTailLengthSeconds() const { return 0.0; }
+double TransformerAudioProcessor::getTailLengthSeconds() const
+{
+    // Filter delay plus the crossover, oversampling and hysteresis ringing out
+    // (see TransformerEngine::getTailSamples)
+    return sampleRate > 0.0 ? tailSamples.load() / sampleRate : 0.0;
+}
 int TransformerAudioProcessor::getNumPrograms() { return 1; }
 int TransformerAudioProcessor::getCurrentProgram() { return 0; }
 void TransformerAudioProcessor::setCurrentProgram(int index) { }
@@ -77,39 +236,236 @@ void TransformerAudioProcessor::prepareToPlay(double newSampleRate, int samplesP
 {
     sampleRate = newSampleRate;
     
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = newSampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = getTotalNumOutputChannels();
+    // Models for the main bus only; the sidechain is never processed
+    const int numChannels = juce::jmax(getMainBusNumInputChannels(), getMainBusNumOutputChannels());
+    const auto settings = getCurrentSettings();
+    metering.prepare(newSampleRate);
+    stageProfiler.reset();
     
-    // Setup multiband processing for frequency-dependent transformer behavior
-    lowPassFilter.reset();
-    highPassFilter.reset();
+    // Hosts set the processing precision before preparing, so only that engine
+    // needs its storage
+    if (isUsingDoublePrecision())
+    {
+        floatEngine.release();
+        doubleEngine.prepare(newSampleRate, numChannels, samplesPerBlock, settings);
+        latencySamples.store(doubleEngine.getLatencySamples());
+        tailSamples.store(doubleEngine.getTailSamples());
+    }
+    else
+    {
+        doubleEngine.release();
+        floatEngine.prepare(newSampleRate, numChannels, samplesPerBlock, settings);
+        latencySamples.store(floatEngine.getLatencySamples());
+        tailSamples.store(floatEngine.getTailSamples());
+    }
+    
+    setLatencySamples(latencySamples.load());
+    
+    shaperTableBuilder.request(kLiveShaperTable, settings.evenHarmonics, settings.oddHarmonics, settings.asymmetry);
+    requestSnapshotShaperTables();
     
-    // Crossover frequency at 1kHz - typical for transformer frequency response changes
-    *lowPassFilter.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass(newSampleRate, 1000.0f);
-    *highPassFilter.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass(newSampleRate, 1000.0f);
+    // Exact shaping and offline renders never use the builder's tables; switching
+    // to a table mode later starts it from timerCallback
+    if (settings.shaperMode > 0 && ! settings.nonRealtime)
+        shaperTableBuilder.start();
     
-    lowPassFilter.prepare(spec);
-    highPassFilter.prepare(spec);
+    // The engines built their first Everett table themselves; the builder only
+    // runs for realtime Preisach playback
+    everettTableBuilder.request(kLiveEverettTable, settings.preisachResolution, settings.hysteresis);
+    requestSnapshotEverettTables(settings.preisachResolution);
     
-    // Reset transformer models
-    transformerModelL.reset();
-    transformerModelR.reset();
+    if (settings.preisach && ! settings.nonRealtime)
+        everettTableBuilder.start();
+    
+    // The engines built their first linear phase filters themselves; the builder
+    // follows the settings from here, and only runs for linear phase playback
+    crossoverDesignBuilder.prepare(newSampleRate);
+    crossoverDesignBuilder.request(settings.numBands, settings.crossoverFrequencies);
+    
+    if (settings.crossoverMode == CrossoverLayout::Mode::linearPhase && ! settings.nonRealtime)
+        crossoverDesignBuilder.start();
 }
 
 void TransformerAudioProcessor::releaseResources()
 {
+    floatEngine.release();
+    doubleEngine.release();
+    startShaperTableBuilder.store(false);
+    shaperTableBuilder.stop();
+    startEverettTableBuilder.store(false);
+    everettTableBuilder.stop();
+    startCrossoverDesignBuilder.store(false);
+    crossoverDesignBuilder.stop();
+}
+
+int TransformerAudioProcessor::getRequestedOversamplingOrder() const
+{
+    const int maxOrder = TransformerEngine<float>::kMaxOversamplingOrder;
+    const int realtimeOrder = juce::roundToInt(oversamplingParameter->load());
+    const int renderOrder = juce::roundToInt(renderQualityParameter->load());
+    
+    // Offline bounces use the render quality setting unless it follows realtime
+    if (isNonRealtime() && renderOrder > 0)
+        return juce::jlimit(0, maxOrder, renderOrder);
+    
+    return juce::jlimit(0, maxOrder, realtimeOrder);
+}
+
+TransformerSettings TransformerAudioProcessor::getCurrentSettings() const
+{
+    // The morph is worked out once per block; the engine's smoothers take it
+    // from there
+    const auto morph = snapshotMorphParameter->load() >= 0.5f ? snapshots.getMorph(morphXParameter->load(), morphYParameter->load())
+                                                              : ParameterSnapshots::Morph();
+    const auto value = [&morph](const ParameterSnapshots::Parameter* parameter)
+    {
+        return ParameterSnapshots::getValue(*parameter, morph);
+    };
+    
+    TransformerSettings settings;
+    settings.drive = value(driveParameter);
+    settings.outputGain = value(outputGainParameter);
+    settings.evenHarmonics = value(evenHarmonicsParameter);
+    settings.oddHarmonics = value(oddHarmonicsParameter);
+    settings.hysteresis = value(hysteresisParameter);
+    settings.asymmetry = value(asymmetryParameter);
+    
+    for (size_t band = 0; band < bandDriveParameters.size(); ++band)
+        settings.bandDrives[band] = value(bandDriveParameters[band]);
+    
+    for (size_t split = 0; split < crossoverParameters.size(); ++split)
+        settings.crossoverFrequencies[split] = value(crossoverParameters[split]);
+    
+    settings.numBands = CrossoverLayout::kMinBands + juce::roundToInt(value(numBandsParameter));
+    settings.crossoverMode = juce::roundToInt(crossoverModeParameter->load()) == 1 ? CrossoverLayout::Mode::linearPhase
+                                                                                   : CrossoverLayout::Mode::linkwitzRiley;
+    settings.oversamplingOrder = getRequestedOversamplingOrder();
+    settings.preisach = juce::roundToInt(value(hysteresisModelParameter)) == 1;
+    settings.preisachResolution = PreisachOperator<float>::kMinResolution << juce::roundToInt(preisachResolutionParameter->load());
+    settings.shaperMode = juce::roundToInt(shaperParameter->load());
+    settings.everettTable = realtimeEverettTable;
+    settings.shaperTable = realtimeShaperTable;
+    settings.sidechainMode = juce::roundToInt(value(sidechainModeParameter));
+    settings.sidechainDepth = value(sidechainDepthParameter);
+    settings.sidechainAttack = value(sidechainAttackParameter);
+    settings.sidechainRelease = value(sidechainReleaseParameter);
+    settings.nonRealtime = isNonRealtime();
+    return settings;
+}
+
+const ShaperTable* TransformerAudioProcessor::acquireShaperTable(const TransformerSettings& settings)
+{
+    // Realtime table builds happen on the builder thread; the audio thread only
+    // posts the targets and picks up whichever table is ready
+    shaperTableBuilder.request(kLiveShaperTable, settings.evenHarmonics, settings.oddHarmonics, settings.asymmetry);
+    const ShaperTable* table = shaperTableBuilder.acquire(kLiveShaperTable);
+    
+    // Right after a recall, or with the morph resting on a snapshot, that
+    // snapshot's table is already there while the live one is still building
+    for (int snapshot = 0; snapshot < ParameterSnapshots::kNumSnapshots; ++snapshot)
+    {
+        const auto* snapshotTable = shaperTableBuilder.acquire(kLiveShaperTable + 1 + snapshot);
+        
+        if (snapshotTable != nullptr && snapshotTable->matches(settings.evenHarmonics, settings.oddHarmonics, settings.asymmetry))
+            table = snapshotTable;
+    }
+    
+    return table;
+}
+
+void TransformerAudioProcessor::requestSnapshotShaperTables()
+{
+    for (int snapshot = 0; snapshot < ParameterSnapshots::kNumSnapshots; ++snapshot)
+        if (snapshots.isStored(snapshot))
+            shaperTableBuilder.request(kLiveShaperTable + 1 + snapshot,
+                                       snapshots.getStoredValue(snapshot, *evenHarmonicsParameter),
+                                       snapshots.getStoredValue(snapshot, *oddHarmonicsParameter),
+                                       snapshots.getStoredValue(snapshot, *asymmetryParameter));
+}
+
+const EverettTable* TransformerAudioProcessor::acquireEverettTable(const TransformerSettings& settings, float width)
+{
+    everettTableBuilder.request(kLiveEverettTable, settings.preisachResolution, width);
+    const EverettTable* table = everettTableBuilder.acquire(kLiveEverettTable);
+    
+    // Snapshot tables follow the resolution, and pick up snapshots stored since
+    // the last block; unchanged requests cost a few atomic loads
+    requestSnapshotEverettTables(settings.preisachResolution);
+    
+    // Once a recall or a morph comes to rest on a snapshot's loop width, its
+    // table is there without waiting for the live one
+    for (int snapshot = 0; snapshot < ParameterSnapshots::kNumSnapshots; ++snapshot)
+    {
+        const auto* snapshotTable = everettTableBuilder.acquire(kLiveEverettTable + 1 + snapshot);
+        
+        if (snapshotTable != nullptr && snapshotTable->matches(settings.preisachResolution, width))
+            table = snapshotTable;
+    }
+    
+    return table;
+}
+
+void TransformerAudioProcessor::requestSnapshotEverettTables(int resolution)
+{
+    for (int snapshot = 0; snapshot < ParameterSnapshots::kNumSnapshots; ++snapshot)
+        if (snapshots.isStored(snapshot))
+            everettTableBuilder.request(kLiveEverettTable + 1 + snapshot, resolution,
+                                        snapshots.getStoredValue(snapshot, *hysteresisParameter));
+}
+
+void TransformerAudioProcessor::storeSnapshot(int snapshot)
+{
+    snapshots.store(snapshot);
+    requestSnapshotShaperTables();
+}
+
+void TransformerAudioProcessor::recallSnapshot(int snapshot)
+{
+    snapshots.recall(snapshot);
+}
+
+void TransformerAudioProcessor::clearSnapshot(int snapshot)
+{
+    snapshots.clear(snapshot);
+}
+
+bool TransformerAudioProcessor::isSnapshotStored(int snapshot) const
+{
+    return snapshots.isStored(snapshot);
+}
+
+void TransformerAudioProcessor::timerCallback()
+{
+    // Latency changes are reported from the message thread, and the background
+    // builders started when processBlock first wants their results
+    if (latencySamples.load() != getLatencySamples())
+        setLatencySamples(latencySamples.load());
+    
+    if (startShaperTableBuilder.exchange(false))
+        shaperTableBuilder.start();
+    
+    if (startEverettTableBuilder.exchange(false))
+        everettTableBuilder.start();
+    
+    if (startCrossoverDesignBuilder.exchange(false))
+        crossoverDesignBuilder.start();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool TransformerAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono() &&
-        layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout up to kMaxChannels (mono through 7.1.4 beds and discrete sets);
+    // every channel gets its own models, so the channel order doesn't matter
+    const auto& output = layouts.getMainOutputChannelSet();
+
+    if (output.isDisabled() || output.size() > kMaxChannels)
         return false;
 
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+    if (output != layouts.getMainInputChannelSet())
+        return false;
+
+    // The sidechain may be off, or any width up to kMaxChannels
+    if (layouts.inputBuses.size() > 1 && layouts.getChannelSet(true, 1).size() > kMaxChannels)
         return false;
 
     return true;
@@ -118,71 +474,89 @@ bool TransformerAudioProcessor::isBusesLayoutSupported(const BusesLayout& layout
 
 void TransformerAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, 
                                          juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, floatEngine);
+}
+
+void TransformerAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer,
+                                         juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, doubleEngine);
+}
+
+bool TransformerAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void TransformerAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer,
+                                               TransformerEngine<SampleType>& engine)
 {
     juce::ScopedNoDenormals noDenormals;
-    int totalNumInputChannels = getTotalNumInputChannels();
+    RealtimeAllocationGuard::ScopedRealtimeSection realtimeSection;
+    
+    int totalNumInputChannels = getMainBusNumInputChannels();
     int numSamples = buffer.getNumSamples();
     
     // Clear any output channels beyond the input channels
     for (int channel = totalNumInputChannels; channel < getTotalNumOutputChannels(); ++channel)
         buffer.clear(channel, 0, numSamples);
     
-    // Get parameters
-    float drive = parameters.getRawParameterValue("drive")->load();
-    float outputGain = parameters.getRawParameterValue("outputGain")->load();
-    float evenHarmonics = parameters.getRawParameterValue("evenHarmonics")->load();
-    float oddHarmonics = parameters.getRawParameterValue("oddHarmonics")->load();
-    float hysteresis = parameters.getRawParameterValue("hysteresis")->load();
-    float asymmetry = parameters.getRawParameterValue("asymmetry")->load();
-    
-    // Update transformer model parameters
-    transformerModelL.setDensityParams(hysteresis, asymmetry);
-    transformerModelL.setHarmonics(evenHarmonics, oddHarmonics);
-    transformerModelR.setDensityParams(hysteresis, asymmetry);
-    transformerModelR.setHarmonics(evenHarmonics, oddHarmonics);
-    
-    // Create temporary buffers for multiband processing
-    juce::AudioBuffer<float> lowFreqBuffer(buffer.getNumChannels(), numSamples);
-    juce::AudioBuffer<float> highFreqBuffer(buffer.getNumChannels(), numSamples);
-    
-    // Copy input to both bands
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
-    {
-        lowFreqBuffer.copyFrom(channel, 0, buffer, channel, 0, numSamples);
-        highFreqBuffer.copyFrom(channel, 0, buffer, channel, 0, numSamples);
-    }
+    // Only the engine for the current precision is prepared
+    jassert(engine.isPrepared());
     
-    // Process crossover filters
-    juce::dsp::AudioBlock<float> lowBlock(lowFreqBuffer);
-    juce::dsp::ProcessContextReplacing<float> lowContext(lowBlock);
-    lowPassFilter.process(lowContext);
+    if (! engine.isPrepared())
+        return;
     
-    juce::dsp::AudioBlock<float> highBlock(highFreqBuffer);
-    juce::dsp::ProcessContextReplacing<float> highContext(highBlock);
-    highPassFilter.process(highContext);
+    // Parameter, band, crossover and oversampling changes (including
+    // realtime/offline switches) take effect before the block
+    auto settings = getCurrentSettings();
     
-    // Apply Preisach transformer model to each band with different intensities
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    if (settings.shaperMode > 0 && ! settings.nonRealtime)
     {
-        float* originalData = buffer.getWritePointer(channel);
-        float* lowData = lowFreqBuffer.getWritePointer(channel);
-        float* highData = highFreqBuffer.getWritePointer(channel);
+        // A table mode was picked after prepareToPlay; the timer starts the
+        // builder on the message thread, with exact shaping until its first table
+        if (! shaperTableBuilder.isRunning())
+            startShaperTableBuilder.store(true);
         
-        // Use appropriate model based on channel (L/R)
-        PreisachTransformerModel& model = (channel == 0) ? transformerModelL : transformerModelR;
+        realtimeShaperTable = acquireShaperTable(settings);
+        settings.shaperTable = realtimeShaperTable;
+    }
+    
+    // The Preisach operator's Everett table follows the loop width the engine is
+    // smoothing through, one background-built table at a time
+    if (settings.preisach && ! settings.nonRealtime)
+    {
+        if (! everettTableBuilder.isRunning())
+            startEverettTableBuilder.store(true);
         
-        for (int sample = 0; sample < numSamples; ++sample)
-        {
-            // Process low frequencies with more intense saturation (transformers affect lows more)
-            float saturatedLow = model.process(lowData[sample], drive * 1.5f);
-            
-            // Process high frequencies with less saturation
-            float saturatedHigh = model.process(highData[sample], drive * 0.5f);
-            
-            // Mix back together and apply output gain
-            originalData[sample] = (saturatedLow + saturatedHigh) * outputGain;
-        }
+        realtimeEverettTable = acquireEverettTable(settings, engine.getHysteresisWidth());
+        settings.everettTable = realtimeEverettTable;
     }
+    
+    // Likewise for the linear phase filters, which would otherwise be rebuilt on
+    // this thread whenever a crossover frequency moves
+    if (settings.crossoverMode == CrossoverLayout::Mode::linearPhase && ! settings.nonRealtime)
+    {
+        if (! crossoverDesignBuilder.isRunning())
+            startCrossoverDesignBuilder.store(true);
+        
+        crossoverDesignBuilder.request(settings.numBands, settings.crossoverFrequencies);
+        settings.crossoverDesign = crossoverDesignBuilder.acquire();
+    }
+    
+    // The timer reports a latency change to the host
+    engine.update(settings);
+    latencySamples.store(engine.getLatencySamples());
+    tailSamples.store(engine.getTailSamples());
+    
+    // The sidechain's channels follow the main bus's in the buffer
+    const bool hasSidechain = getBusCount(true) > 1 && getChannelCountOfBus(true, 1) > 0;
+    const auto sidechain = hasSidechain ? getBusBuffer(buffer, true, 1) : juce::AudioBuffer<SampleType>();
+    
+    // Skips the signal path entirely once input and tail are silent
+    engine.process(buffer, totalNumInputChannels, hasSidechain ? &sidechain : nullptr);
 }
 
 bool TransformerAudioProcessor::hasEditor() const
@@ -197,17 +571,32 @@ juce::AudioProcessorEditor* TransformerAudioProcessor::createEditor()
 
 void TransformerAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    // Compact binary parameters and snapshots (see ParameterSnapshots)
+    snapshots.writeState(destData);
 }
 
 void TransformerAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+    // Parameters change through the value tree without any gesture, and the
+    // engine glides to the new state without being reset
+    if (snapshots.readState(data, sizeInBytes))
+    {
+        requestSnapshotShaperTables();
+        return;
+    }
+    
+    // Older sessions saved the value tree as XML, without snapshots
     std::unique_ptr<juce::XmlElement> xml(getXmlFromBinary(data, sizeInBytes));
     if (xml != nullptr)
+    {
         if (xml->hasTagName(parameters.state.getType()))
+        {
             parameters.replaceState(juce::ValueTree::fromXml(*xml));
+            
+            for (int snapshot = 0; snapshot < ParameterSnapshots::kNumSnapshots; ++snapshot)
+                snapshots.clear(snapshot);
+        }
+    }
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -1,92 +1,16 @@
 #pragma once
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include "TransformerEngine.h"
+#include "ShaperTableBuilder.h"
+#include "EverettTableBuilder.h"
+#include "LinearPhaseDesignBuilder.h"
+#include "Metering.h"
+#include "StageProfiler.h"
+#include "ParameterSnapshots.h"
 
-// Preisach hysteresis model for transformer saturation
-class PreisachTransformerModel
-{
-public:
-    PreisachTransformerModel() 
-    {
-        // Initialize with default values
-        reset();
-    }
-    
-    void reset()
-    {
-        // Clear history and reset state
-        mPreviousInput = 0.0f;
-        mHistoryState.clear();
-        
-        // Initialize 10 history points for hysteresis (can be adjusted)
-        for (int i = 0; i < 10; ++i)
-            mHistoryState.push_back(0.0f);
-    }
-    
-    void setDensityParams(float width, float skew)
-    {
-        mWidth = width;
-        mSkew = skew;
-    }
-    
-    void setHarmonics(float evenHarmonics, float oddHarmonics)
-    {
-        mEvenHarmonics = evenHarmonics;
-        mOddHarmonics = oddHarmonics;
-    }
-    
-    float process(float input, float drive)
-    {
-        // Apply drive and input conditioning
-        float x = input * drive;
-        
-        // Preisach hysteresis model calculation
-        float output = 0.0f;
-        
-        // Update history
-        mHistoryState.pop_back();
-        mHistoryState.insert(mHistoryState.begin(), x);
-        
-        // Calculate weighted sum of history to simulate hysteresis
-        float weightSum = 0.0f;
-        for (size_t i = 0; i < mHistoryState.size(); ++i)
-        {
-            float weight = std::exp(-static_cast<float>(i) * mWidth);
-            weightSum += weight;
-            output += mHistoryState[i] * weight;
-        }
-        
-        // Normalize
-        if (weightSum > 0.0f)
-            output /= weightSum;
-        
-        // Apply nonlinear shaping for harmonics
-        float sign = (output >= 0.0f) ? 1.0f : -1.0f;
-        float absOutput = std::abs(output);
-        
-        // Tanh for odd harmonics, squared term for even harmonics
-        float oddTerm = std::tanh(absOutput * mOddHarmonics);
-        float evenTerm = absOutput * absOutput * sign * mEvenHarmonics;
-        
-        // Combine and apply skew for asymmetrical distortion
-        float shaped = (oddTerm + evenTerm) * (1.0f + mSkew * sign);
-        
-        // Store for next iteration
-        mPreviousInput = input;
-        
-        return shaped;
-    }
-    
-private:
-    std::vector<float> mHistoryState;
-    float mPreviousInput = 0.0f;
-    float mWidth = 0.2f;      // Controls how quickly past states decay
-    float mSkew = 0.1f;       // Controls asymmetry of saturation
-    float mEvenHarmonics = 0.3f; // Controls amount of even harmonics
-    float mOddHarmonics = 1.0f;  // Controls amount of odd harmonics
-};
-
-class TransformerAudioProcessor  : public juce::AudioProcessor
+class TransformerAudioProcessor  : public juce::AudioProcessor,
+                                   private juce::Timer
 {
 public:
     TransformerAudioProcessor();
@@ -98,6 +22,8 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
     const juce::String getName() const override;
@@ -114,16 +40,113 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
     
     juce::AudioProcessorValueTreeState parameters;
+    
+    // Levels and scope data for the editor
+    MeteringSource& getMetering() { return metering; }
+    
+    // Per-stage timings; only recorded in builds with TRANSFORMER_PROFILE_STAGES
+    StageProfiler& getStageProfiler() { return stageProfiler; }
+    
+    // Message thread: snapshots A-D (0-3). Storing captures the current sound
+    // parameters and has the snapshot's shaper table built ahead of time, so
+    // recalling it or morphing onto it switches without waiting for a build
+    void storeSnapshot(int snapshot);
+    void recallSnapshot(int snapshot);
+    void clearSnapshot(int snapshot);
+    bool isSnapshotStored(int snapshot) const;
 
 private:
-    juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, 
-                                  juce::dsp::IIR::Coefficients<float>> lowPassFilter;
-    juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, 
-                                  juce::dsp::IIR::Coefficients<float>> highPassFilter;
+    // Shared by both precisions; engine is the one prepared for the host
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, TransformerEngine<SampleType>& engine);
+    
+    // Current parameter values for the engines, or the snapshot morph's while
+    // morphing is on
+    TransformerSettings getCurrentSettings() const;
+    
+    // Realtime shaper table for these settings: a snapshot's prebuilt table when
+    // the settings are exactly that snapshot's, otherwise the live one
+    const ShaperTable* acquireShaperTable(const TransformerSettings& settings);
+    void requestSnapshotShaperTables();
+    const EverettTable* acquireEverettTable(const TransformerSettings& settings, float width);
+    void requestSnapshotEverettTables(int resolution);
+    
+    // Oversampling order (0 = off) for the current realtime/offline state
+    int getRequestedOversamplingOrder() const;
+    
+    // Message thread: reports latency changes and starts the background builders
+    // the audio thread has asked for. The audio thread only sets atomics, since
+    // posting a message can lock or allocate.
+    void timerCallback() override;
+    static constexpr int kTimerIntervalMs = 50;
+    
+    // Largest bus layout accepted (7.1.4 plus spare discrete channels)
+    static constexpr int kMaxChannels = 16;
+    
+    // Drive parameters exist for the most bands the crossover can produce
+    static constexpr int kMaxBands = CrossoverLayout::kMaxBands;
+    
+    // Sound parameters, read through the snapshots so they can be morphed
+    const ParameterSnapshots::Parameter* driveParameter = nullptr;
+    const ParameterSnapshots::Parameter* outputGainParameter = nullptr;
+    const ParameterSnapshots::Parameter* evenHarmonicsParameter = nullptr;
+    const ParameterSnapshots::Parameter* oddHarmonicsParameter = nullptr;
+    const ParameterSnapshots::Parameter* hysteresisParameter = nullptr;
+    const ParameterSnapshots::Parameter* asymmetryParameter = nullptr;
+    const ParameterSnapshots::Parameter* numBandsParameter = nullptr;
+    const ParameterSnapshots::Parameter* hysteresisModelParameter = nullptr;
+    const ParameterSnapshots::Parameter* sidechainModeParameter = nullptr;
+    const ParameterSnapshots::Parameter* sidechainDepthParameter = nullptr;
+    const ParameterSnapshots::Parameter* sidechainAttackParameter = nullptr;
+    const ParameterSnapshots::Parameter* sidechainReleaseParameter = nullptr;
+    std::array<const ParameterSnapshots::Parameter*, CrossoverLayout::kMaxSplits> crossoverParameters {};
+    std::array<const ParameterSnapshots::Parameter*, kMaxBands> bandDriveParameters {};
+    
+    // Quality, latency and morph parameters stay out of the snapshots; raw
+    // values, cached at construction
+    std::atomic<float>* oversamplingParameter = nullptr;
+    std::atomic<float>* renderQualityParameter = nullptr;
+    std::atomic<float>* crossoverModeParameter = nullptr;
+    std::atomic<float>* preisachResolutionParameter = nullptr;
+    std::atomic<float>* shaperParameter = nullptr;
+    std::atomic<float>* snapshotMorphParameter = nullptr;
+    std::atomic<float>* morphXParameter = nullptr;
+    std::atomic<float>* morphYParameter = nullptr;
+    
+    // Snapshots A-D and the binary state format
+    ParameterSnapshots snapshots { parameters };
+    
+    // Shaper lookup tables for realtime playback, built in the background:
+    // kLiveShaperTable follows the current settings, the rest hold one per snapshot
+    static constexpr int kLiveShaperTable = 0;
+    ShaperTableBuilder shaperTableBuilder { 1 + ParameterSnapshots::kNumSnapshots };
+    const ShaperTable* realtimeShaperTable = nullptr;
+    
+    // Set by the audio thread when a table mode is in use before the builder runs
+    std::atomic<bool> startShaperTableBuilder { false };
+    
+    // Everett tables for the Preisach operator in realtime playback, built in
+    // the background: kLiveEverettTable follows the engine's smoothed loop width,
+    // the rest hold one per snapshot like the shaper tables
+    static constexpr int kLiveEverettTable = 0;
+    EverettTableBuilder everettTableBuilder { 1 + ParameterSnapshots::kNumSnapshots };
+    const EverettTable* realtimeEverettTable = nullptr;
+    std::atomic<bool> startEverettTableBuilder { false };
+    
+    // Linear phase crossover filters for realtime playback, built in the background
+    LinearPhaseDesignBuilder crossoverDesignBuilder;
+    std::atomic<bool> startCrossoverDesignBuilder { false };
+    
+    // Only fed while an editor is open
+    MeteringSource metering;
+    StageProfiler stageProfiler;
     
-    PreisachTransformerModel transformerModelL;
-    PreisachTransformerModel transformerModelR;
+    // The signal path at each precision; only the one in use holds any storage
+    TransformerEngine<float> floatEngine { metering };
+    TransformerEngine<double> doubleEngine { metering };
     
+    std::atomic<int> latencySamples { 0 };
+    std::atomic<int> tailSamples { 0 };
     double sampleRate = 44100.0;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransformerAudioProcessor)
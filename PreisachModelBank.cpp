@@ -0,0 +1,309 @@
+#include "PreisachModelBank.h"
+#include "ShaperKernels.h"
+#include <algorithm>
+#include <cmath>
+
+template <typename SampleType>
+PreisachModelBank<SampleType>::PreisachModelBank()
+{
+    rebuildDecayWeights();
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::prepare(int numChannels, int numBands, int maxBlockSize)
+{
+    mNumChannels = std::max(0, numChannels);
+    mNumBands = std::max(0, numBands);
+    mMaxBands = mNumBands;
+    mMaxBlockSize = std::max(1, maxBlockSize);
+
+    const int numLanes = getNumLanes();
+    mLaneStride = ((numLanes + kLaneAlignment - 1) / kLaneAlignment) * kLaneAlignment;
+
+    mFrames.assign((size_t) (mMaxBlockSize * mLaneStride), SampleType(0));
+    mHistory.assign((size_t) (2 * kMaxHistoryDepth * mLaneStride), SampleType(0));
+    mLaneDrive.assign((size_t) mLaneStride, SampleType(1));
+    mAccumulator.assign((size_t) mLaneStride, SampleType(0));
+    mPreisach.prepare(numLanes);
+
+    reset();
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::setNumActiveBands(int numBands)
+{
+    numBands = std::clamp(numBands, std::min(1, mMaxBands), mMaxBands);
+
+    if (numBands == mNumBands)
+        return;
+
+    // Fewer lanes pack into a narrower frame; the storage is sized for mMaxBands
+    mNumBands = numBands;
+    const int numLanes = getNumLanes();
+    mLaneStride = ((numLanes + kLaneAlignment - 1) / kLaneAlignment) * kLaneAlignment;
+    reset();
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::reset()
+{
+    // The frames too: a change of lane stride moves the padding lanes, which
+    // process() shapes and the history copies along with the active ones
+    std::fill(mFrames.begin(), mFrames.end(), SampleType(0));
+    std::fill(mHistory.begin(), mHistory.end(), SampleType(0));
+    mWritePos = 0;
+
+    // Demagnetising costs a few hundred steps per lane, so only when it's in use
+    if (mHysteresisModel == HysteresisModel::preisach)
+        mPreisach.reset();
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::setHistoryDepth(int depth)
+{
+    depth = std::clamp(depth, 1, kMaxHistoryDepth);
+
+    if (depth == mHistoryDepth)
+        return;
+
+    mHistoryDepth = depth;
+    rebuildDecayWeights();
+    reset();
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::setOversamplingFactor(int factor)
+{
+    factor = std::max(1, factor);
+
+    if (factor == mOversamplingFactor)
+        return;
+
+    mOversamplingFactor = factor;
+    mPreisach.setSampleRate(mSampleRate * mOversamplingFactor);
+    rebuildDecayWeights();
+    reset();
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::setSampleRate(double sampleRate)
+{
+    mSampleRate = sampleRate;
+    mPreisach.setSampleRate(mSampleRate * mOversamplingFactor);
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::setHysteresisModel(HysteresisModel model)
+{
+    if (model == mHysteresisModel)
+        return;
+
+    mHysteresisModel = model;
+    reset();
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::setEverettTable(const EverettTable& table)
+{
+    mPreisach.setTable(table);
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::setDensityParams(float width, float skew)
+{
+    mSkew = skew;
+
+    // The decay weights only depend on the width, so only rebuild when it moves.
+    // The Preisach operator gets the width with its Everett table instead.
+    if (width != mWidth)
+    {
+        mWidth = width;
+        rebuildDecayWeights();
+    }
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::setHarmonics(float evenHarmonics, float oddHarmonics)
+{
+    mEvenHarmonics = evenHarmonics;
+    mOddHarmonics = oddHarmonics;
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::setBandDrive(int band, float drive)
+{
+    if (band < 0 || band >= mMaxBands)
+        return;
+
+    std::fill_n(mLaneDrive.begin() + band * mNumChannels, mNumChannels, static_cast<SampleType>(drive));
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::setShaperTable(const ShaperTable* table, ShaperTable::Interpolation interpolation)
+{
+    mShaperTable = table;
+    mShaperInterpolation = interpolation;
+}
+
+template <typename SampleType>
+int PreisachModelBank<SampleType>::getTailSamples() const
+{
+    if (mHysteresisModel == HysteresisModel::preisach)
+        return (int) std::ceil(std::log(1.0e6) / (2.0 * 3.141592653589793 * PreisachOperator<SampleType>::kDcBlockerFrequency) * mSampleRate);
+
+    return mHistoryDepth;
+}
+
+template <typename SampleType>
+SampleType PreisachModelBank<SampleType>::getStateMagnitude() const
+{
+    if (mHysteresisModel == HysteresisModel::preisach)
+        return mPreisach.getStateMagnitude(getNumLanes());
+
+    // Padding lanes carry nothing, so only the active lanes of each frame count
+    const int numLanes = getNumLanes();
+    const int numFrames = mLaneStride > 0 ? (int) mHistory.size() / mLaneStride : 0;
+    SampleType magnitude = 0;
+
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        const SampleType* values = mHistory.data() + frame * mLaneStride;
+
+        for (int lane = 0; lane < numLanes; ++lane)
+            magnitude = std::max(magnitude, std::abs(values[lane]));
+    }
+
+    return magnitude;
+}
+
+template <typename SampleType>
+void PreisachModelBank<SampleType>::process(SampleType* const* laneData, int numSamples, const SampleType* driveRamp)
+{
+    const int numLanes = getNumLanes();
+    const int stride = mLaneStride;
+
+    if (numLanes == 0 || numSamples <= 0)
+        return;
+
+    numSamples = std::min(numSamples, mMaxBlockSize);
+
+    SampleType* frames = mFrames.data();
+    const SampleType* laneDrive = mLaneDrive.data();
+
+    {
+        TRANSFORMER_PROFILE_STAGE(mProfiler, hysteresis);
+
+        // Interleave the lanes into frames, applying each lane's drive
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            const SampleType* src = laneData[lane];
+            const SampleType drive = laneDrive[lane];
+
+            if (driveRamp != nullptr)
+            {
+                for (int sample = 0; sample < numSamples; ++sample)
+                    frames[sample * stride + lane] = src[sample] * drive * driveRamp[sample];
+            }
+            else
+            {
+                for (int sample = 0; sample < numSamples; ++sample)
+                    frames[sample * stride + lane] = src[sample] * drive;
+            }
+        }
+
+        if (mHysteresisModel == HysteresisModel::preisach)
+        {
+            // Each lane walks its own memory curve, so lanes run one after another
+            for (int lane = 0; lane < numLanes; ++lane)
+                for (int sample = 0; sample < numSamples; ++sample)
+                    frames[sample * stride + lane] = mPreisach.processSample(lane, frames[sample * stride + lane]);
+        }
+        else
+        {
+            advanceHistory(numSamples);
+        }
+    }
+
+    TRANSFORMER_PROFILE_STAGE(mProfiler, shaping);
+
+    // One shaping pass over every lane of the block
+    if (mShaperTable != nullptr)
+        mShaperTable->process(frames, numSamples * stride, mShaperInterpolation);
+    else
+        ShaperKernels::shape(frames, numSamples * stride, mEvenHarmonics, mOddHarmonics, mSkew);
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        SampleType* dst = laneData[lane];
+
+        for (int sample = 0; sample < numSamples; ++sample)
+            dst[sample] = frames[sample * stride + lane];
+    }
+}
+
+// Advances every lane's history together; the inner loops run across lanes
+template <typename SampleType>
+void PreisachModelBank<SampleType>::advanceHistory(int numSamples)
+{
+    const int stride = mLaneStride;
+    SampleType* frames = mFrames.data();
+    SampleType* history = mHistory.data();
+    SampleType* acc = mAccumulator.data();
+    const SampleType* weights = mDecayWeights.data();
+    const int depth = mNumTaps;
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        SampleType* frame = frames + sample * stride;
+
+        mWritePos = (mWritePos == 0 ? depth : mWritePos) - 1;
+        std::copy_n(frame, stride, history + mWritePos * stride);
+        std::copy_n(frame, stride, history + (mWritePos + depth) * stride);
+
+        const SampleType* window = history + mWritePos * stride;
+
+        for (int lane = 0; lane < stride; ++lane)
+            acc[lane] = window[lane] * weights[0];
+
+        for (int i = 1; i < depth; ++i)
+        {
+            const SampleType weight = weights[i];
+            const SampleType* tap = window + i * stride;
+
+            for (int lane = 0; lane < stride; ++lane)
+                acc[lane] += tap[lane] * weight;
+        }
+
+        std::copy_n(acc, stride, frame);
+    }
+}
+
+// exp(-i * width) for each tap, folded together with the normalisation factor.
+// At an oversampled rate there are proportionally more taps decaying more slowly.
+template <typename SampleType>
+void PreisachModelBank<SampleType>::rebuildDecayWeights()
+{
+    mNumTaps = std::min(mHistoryDepth * mOversamplingFactor, kMaxHistoryDepth);
+    const SampleType width = mWidth / static_cast<SampleType>(mOversamplingFactor);
+
+    // exp(-i * width) as powers of one exp, so following a moving width (snapshot
+    // morphs, automation) costs one exp per chunk rather than one per tap
+    const SampleType ratio = std::exp(-width);
+    SampleType weight = 1;
+    SampleType weightSum = 0;
+
+    for (int i = 0; i < mNumTaps; ++i)
+    {
+        mDecayWeights[(size_t) i] = weight;
+        weightSum += weight;
+        weight *= ratio;
+    }
+
+    const SampleType norm = weightSum > SampleType(0) ? SampleType(1) / weightSum : SampleType(0);
+
+    for (int i = 0; i < mNumTaps; ++i)
+        mDecayWeights[(size_t) i] *= norm;
+}
+
+template class PreisachModelBank<float>;
+template class PreisachModelBank<double>;
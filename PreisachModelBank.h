@@ -0,0 +1,136 @@
+#pragma once
+#include "PreisachOperator.h"
+#include "ShaperTable.h"
+#include "StageRecorder.h"
+#include <array>
+#include <vector>
+
+// A bank of independent transformer models, one per channel and band, stored as
+// structure-of-arrays so every lane advances in the same vectorised pass.
+//
+// Lane index = band * numChannels + channel. Samples are interleaved into frames
+// of kLaneAlignment-padded lanes, the hysteresis history is a mirrored ring of
+// such frames, and the harmonic shaping runs once over the whole interleaved block.
+//
+// The hysteresis stage is either the decaying history average (the original
+// model) or a discrete Preisach operator with a staircase memory per lane.
+//
+// SampleType is float or double. Both instantiations (PreisachModelBank.cpp) use
+// the same frame layout; a double frame spans twice the bytes of a float one.
+template <typename SampleType>
+class PreisachModelBank
+{
+public:
+    enum class HysteresisModel
+    {
+        decay,
+        preisach
+    };
+
+    // Enough taps for the default depth at 8x oversampling
+    static constexpr int kMaxHistoryDepth = 128;
+    static constexpr int kDefaultHistoryDepth = 10;
+
+    // Frames are padded to a multiple of this many lanes (one AVX register)
+    static constexpr int kLaneAlignment = 8;
+
+    PreisachModelBank();
+
+    // Allocates all storage for up to numBands bands; must not be called from the
+    // audio thread
+    void prepare(int numChannels, int numBands, int maxBlockSize);
+    void reset();
+
+    // Number of bands processed (clamped to 1..the prepared band count). Only
+    // the first getNumLanes() lanes are touched. Resets the frames and history
+    // when it changes.
+    void setNumActiveBands(int numBands);
+
+    int getNumChannels() const { return mNumChannels; }
+    int getNumBands() const { return mNumBands; }
+    int getNumLanes() const { return mNumChannels * mNumBands; }
+
+    // Number of history points used for hysteresis (clamped to 1..kMaxHistoryDepth)
+    void setHistoryDepth(int depth);
+    int getHistoryDepth() const { return mHistoryDepth; }
+
+    // Stretches the history in time when running at an oversampled rate, so the
+    // hysteresis decay is the same at every factor. Resets the history.
+    void setOversamplingFactor(int factor);
+    int getOversamplingFactor() const { return mOversamplingFactor; }
+
+    // Base sample rate, before oversampling
+    void setSampleRate(double sampleRate);
+
+    // Switching model resets the lanes
+    void setHysteresisModel(HysteresisModel model);
+    HysteresisModel getHysteresisModel() const { return mHysteresisModel; }
+
+    // Everett table for the Preisach operator, copied unless it already runs on
+    // the same one. Its resolution sets the operator's grid (see PreisachOperator).
+    void setEverettTable(const EverettTable& table);
+    int getPreisachResolution() const { return mPreisach.getResolution(); }
+
+    void setDensityParams(float width, float skew);
+    void setHarmonics(float evenHarmonics, float oddHarmonics);
+
+    // Drive applied to every channel of a band
+    void setBandDrive(int band, float drive);
+
+    // Shapes through a lookup table instead of the exact curve, or the exact
+    // curve again with nullptr. The table must outlive its use in process().
+    void setShaperTable(const ShaperTable* table, ShaperTable::Interpolation interpolation);
+
+    // Samples at the base rate until the hysteresis stage has settled after the
+    // input stops: the history depth, or the Preisach DC blocker falling 120 dB
+    int getTailSamples() const;
+
+    // Largest value left in the active lanes of the history ring or the Preisach
+    // DC blockers
+    SampleType getStateMagnitude() const;
+
+    // Receives the hysteresis and shaping stage timings in profiling builds
+    void setProfiler(StageRecorder* profiler) { mProfiler = profiler; }
+
+    // Processes getNumLanes() buffers in place, laneData[band * numChannels + channel].
+    // numSamples must not exceed the maxBlockSize given to prepare(). If driveRamp
+    // is given, every lane's band drive is multiplied by driveRamp[sample].
+    void process(SampleType* const* laneData, int numSamples, const SampleType* driveRamp = nullptr);
+
+private:
+    void rebuildDecayWeights();
+    void advanceHistory(int numSamples);
+
+    int mNumChannels = 0;
+    int mNumBands = 0;
+    int mMaxBands = 0;
+    int mLaneStride = 0;
+    int mMaxBlockSize = 0;
+
+    // Interleaved block scratch, mMaxBlockSize frames of mLaneStride lanes
+    std::vector<SampleType> mFrames;
+
+    // Ring of history frames stored twice over so the window never wraps
+    std::vector<SampleType> mHistory;
+    std::vector<SampleType> mLaneDrive;
+    std::vector<SampleType> mAccumulator;
+
+    const ShaperTable* mShaperTable = nullptr;
+    StageRecorder* mProfiler = nullptr;
+    ShaperTable::Interpolation mShaperInterpolation = ShaperTable::Interpolation::linear;
+
+    HysteresisModel mHysteresisModel = HysteresisModel::decay;
+    PreisachOperator<SampleType> mPreisach;
+    double mSampleRate = 44100.0;
+
+    std::array<SampleType, kMaxHistoryDepth> mDecayWeights {};
+    int mHistoryDepth = kDefaultHistoryDepth;
+    int mOversamplingFactor = 1;
+    int mNumTaps = kDefaultHistoryDepth; // history depth scaled by the oversampling factor
+    int mWritePos = 0;
+
+    float mWidth = 0.2f;
+    float mSkew = 0.1f;
+    float mEvenHarmonics = 0.3f;
+    float mOddHarmonics = 1.0f;
+};
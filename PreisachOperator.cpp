@@ -0,0 +1,140 @@
+#include "PreisachOperator.h"
+#include "ShaperKernels.h"
+#include <algorithm>
+#include <cmath>
+
+template <typename SampleType>
+void PreisachOperator<SampleType>::prepare(int numLanes)
+{
+    mNumLanes = std::max(0, numLanes);
+
+    mStacks.assign((size_t) (mNumLanes * kMaxStackSize), TurningPoint { SampleType(0), SampleType(0) });
+    mStackSize.assign((size_t) mNumLanes, 0);
+    mDirection.assign((size_t) mNumLanes, 1);
+    mExtreme.assign((size_t) mNumLanes, SampleType(0));
+    mDcInput.assign((size_t) mNumLanes, SampleType(0));
+    mDcOutput.assign((size_t) mNumLanes, SampleType(0));
+
+    reset();
+}
+
+template <typename SampleType>
+void PreisachOperator<SampleType>::setSampleRate(double sampleRate)
+{
+    if (sampleRate > 0.0)
+        mDcCoefficient = static_cast<SampleType>(std::exp(-2.0 * 3.141592653589793 * kDcBlockerFrequency / sampleRate));
+}
+
+template <typename SampleType>
+void PreisachOperator<SampleType>::reset()
+{
+    for (int lane = 0; lane < mNumLanes; ++lane)
+    {
+        // Start from negative saturation: every hysteron down
+        mStacks[(size_t) (lane * kMaxStackSize)] = { -kInputRange, SampleType(-1) };
+        mStackSize[(size_t) lane] = 1;
+        mDirection[(size_t) lane] = 1;
+        mExtreme[(size_t) lane] = -kInputRange;
+
+        // AC demagnetisation, shrinking by one cell per half cycle, leaves a
+        // staircase that ends at the origin
+        SampleType sign = 1;
+
+        for (SampleType amplitude = kInputRange; amplitude > SampleType(0.5) * mStep; amplitude -= mStep)
+        {
+            magnetise(lane, sign * amplitude);
+            sign = -sign;
+        }
+
+        magnetise(lane, SampleType(0));
+        mDcInput[(size_t) lane] = SampleType(0);
+        mDcOutput[(size_t) lane] = SampleType(0);
+    }
+}
+
+template <typename SampleType>
+void PreisachOperator<SampleType>::setTable(const EverettTable& table)
+{
+    if (mTable.matches(table.getResolution(), table.getWidth()))
+        return;
+
+    const bool regridded = table.getResolution() != mTable.getResolution();
+    mTable.copyFrom(table);
+
+    // Stored turning points are only meaningful on the grid they were made on
+    if (regridded)
+    {
+        mStep = 2 * kInputRange / static_cast<SampleType>(mTable.getResolution());
+        reset();
+    }
+}
+
+template <typename SampleType>
+SampleType PreisachOperator<SampleType>::processSample(int lane, SampleType input)
+{
+    const SampleType irreversible = magnetise(lane, input);
+    const SampleType reversible = ShaperKernels::fastTanh(input);
+    const SampleType x = (1 - kReversibleFraction) * irreversible + kReversibleFraction * reversible;
+
+    SampleType& previousInput = mDcInput[(size_t) lane];
+    SampleType& previousOutput = mDcOutput[(size_t) lane];
+    previousOutput = x - previousInput + mDcCoefficient * previousOutput;
+    previousInput = x;
+    return previousOutput;
+}
+
+template <typename SampleType>
+SampleType PreisachOperator<SampleType>::getStateMagnitude(int numLanes) const
+{
+    SampleType magnitude = 0;
+    numLanes = std::clamp(numLanes, 0, mNumLanes);
+
+    for (int lane = 0; lane < numLanes; ++lane)
+        magnitude = std::max(magnitude, std::abs(mDcOutput[(size_t) lane]));
+
+    return magnitude;
+}
+
+// The irreversible (hysteron) part of the output, in [-1, 1]
+template <typename SampleType>
+SampleType PreisachOperator<SampleType>::magnetise(int lane, SampleType input)
+{
+    const SampleType u = std::clamp(input, -kInputRange, kInputRange);
+    TurningPoint* stack = mStacks.data() + lane * kMaxStackSize;
+    int& size = mStackSize[(size_t) lane];
+    int& direction = mDirection[(size_t) lane];
+    SampleType& extreme = mExtreme[(size_t) lane];
+
+    // A reversal of at least one grid cell adds the branch extreme as a turning point
+    const bool reversed = direction > 0 ? u <= extreme - mStep : u >= extreme + mStep;
+
+    if (reversed && size < kMaxStackSize)
+    {
+        const auto& top = stack[size - 1];
+        const SampleType output = direction > 0 ? top.output + 2 * mTable.evaluate(extreme, top.input)
+                                                : top.output - 2 * mTable.evaluate(top.input, extreme);
+        stack[size++] = { extreme, output };
+        direction = -direction;
+        extreme = u;
+    }
+    else
+    {
+        extreme = direction > 0 ? std::max(extreme, u) : std::min(extreme, u);
+    }
+
+    // Wiping-out: passing the extremum before the last turning point closes that
+    // minor loop, and the branch continues from the turning point before it
+    while (size > 1 && (direction > 0 ? u > stack[size - 2].input : u < stack[size - 2].input))
+        size -= 2;
+
+    // Read at the branch extreme rather than the input: a reversal smaller than
+    // one cell switches no hysteron, so the output holds instead of running back
+    // along the branch (whose shape depends on older turning points)
+    const auto& top = stack[size - 1];
+
+    return direction > 0 ? top.output + 2 * mTable.evaluate(extreme, top.input)
+                         : top.output - 2 * mTable.evaluate(top.input, extreme);
+}
+
+template class PreisachOperator<float>;
+template class PreisachOperator<double>;
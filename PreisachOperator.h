@@ -0,0 +1,106 @@
+#pragma once
+#include "EverettTable.h"
+#include <vector>
+
+// Discrete scalar Preisach operator for a bank of independent lanes.
+//
+// The hysteron plane (alpha >= beta on a resolution x resolution grid over
+// [-kInputRange, kInputRange]) is never stored. Each lane instead keeps its
+// staircase memory curve as a stack of alternating input extrema, each with the
+// output at that turning point. Congruency means the output along the current
+// branch only depends on the last turning point, through the Everett function:
+//
+//     rising from minimum m:   y = y(m) + 2 E(u, m)
+//     falling from maximum M:  y = y(M) - 2 E(M, u)
+//
+// and wiping-out means an input that passes an older extremum pops the pair of
+// turning points it closes. Every sample therefore costs O(1) amortised plus one
+// bilinear Everett lookup, independent of the grid resolution. Reversals smaller
+// than one grid cell don't switch any hysteron and are not stored; the stack
+// holds at most kMaxStackSize turning points, beyond which reversals are treated
+// the same way.
+//
+// The Everett table (see EverettTable) is integrated from a factorised Gaussian
+// density (coercive field around the loop width, interaction field around zero)
+// and normalised so the irreversible part spans [-1, 1] between negative and
+// positive saturation. The operator runs on its own copy, taken over with
+// setTable(); it never integrates one on the processing thread.
+// A reversible tanh term keeps low-level signals out of the Rayleigh region, and
+// a 5 Hz DC blocker removes the remanence left behind when the input stops.
+//
+// Budget: 25 ns per lane and sample on a current x86 core at any resolution
+// (the stack walk is amortised O(1)), plus copying a (resolution + 1)^2 table
+// whenever the loop width moves, so a stereo two band instance at 48 kHz
+// with 2x oversampling stays under 1% of one core. TransformerBenchmark reports
+// it as "preisach".
+//
+// SampleType is float or double; both are instantiated in PreisachOperator.cpp.
+template <typename SampleType>
+class PreisachOperator
+{
+public:
+    static constexpr int kMinResolution = EverettTable::kMinResolution;
+    static constexpr int kMaxResolution = EverettTable::kMaxResolution;
+    static constexpr int kDefaultResolution = EverettTable::kDefaultResolution;
+
+    // Inputs beyond this (after drive) are in saturation
+    static constexpr SampleType kInputRange = EverettTable::kInputRange;
+
+    // Turning points per lane, including the saturation sentinel
+    static constexpr int kMaxStackSize = kMaxResolution + 2;
+
+    // Share of the output coming from the reversible (anhysteretic) term
+    static constexpr SampleType kReversibleFraction = SampleType(0.5);
+
+    // Corner of the one-pole DC blocker on the output
+    static constexpr double kDcBlockerFrequency = 5.0;
+
+    // Allocates the memory stacks for kMaxResolution; must not be called from the
+    // audio thread
+    void prepare(int numLanes);
+
+    // Rate the lanes run at (including oversampling), for the DC blocker
+    void setSampleRate(double sampleRate);
+
+    // Demagnetises every lane (decaying alternating input down to zero)
+    void reset();
+
+    // Copies the Everett table to run on, unless it already holds the same one.
+    // The grid resolution (cells per axis) comes with it: the lanes are reset
+    // when it changes, and kept when only the loop width moves.
+    void setTable(const EverettTable& table);
+    const EverettTable& getTable() const { return mTable; }
+    int getResolution() const { return mTable.getResolution(); }
+
+    int getNumLanes() const { return mNumLanes; }
+
+    // Advances one lane by one input sample and returns its output, within [-1, 1]
+    // before DC blocking
+    SampleType processSample(int lane, SampleType input);
+
+    // Largest DC blocker output over the first numLanes lanes. The memory curves
+    // never decay, so this is what is still ringing out after the input stops.
+    SampleType getStateMagnitude(int numLanes) const;
+
+private:
+    struct TurningPoint
+    {
+        SampleType input, output;
+    };
+
+    SampleType magnetise(int lane, SampleType input);
+
+    int mNumLanes = 0;
+    SampleType mStep = 2 * kInputRange / kDefaultResolution;
+    SampleType mDcCoefficient = SampleType(0.9993);
+
+    // Allocated for kMaxResolution on construction
+    EverettTable mTable;
+
+    // Per lane memory curve: kMaxStackSize turning points per lane
+    std::vector<TurningPoint> mStacks;
+    std::vector<int> mStackSize;
+    std::vector<int> mDirection;            // +1 rising, -1 falling
+    std::vector<SampleType> mExtreme;       // furthest input on the current branch
+    std::vector<SampleType> mDcInput, mDcOutput;
+};
@@ -0,0 +1,201 @@
+// Drives the Preisach operator through minor loops and checks the two properties
+// that characterise a Preisach model, plus the return point memory they imply:
+//
+//   wiping-out:   an input passing an older extremum erases the turning points it
+//                 dominates, so the output is as if the minor loops never happened
+//   loop closure: returning to the extremum a minor loop started from gives the
+//                 output that extremum had
+//   congruency:   minor loops between the same two inputs have the same shape,
+//                 whatever history led to them
+//
+// Run by CTest; exits with 1 on any failure.
+//
+// The DC blocker runs at a sample rate high enough that it passes the signal
+// unchanged, so outputs compare directly.
+
+#include "EverettTable.h"
+#include "PreisachOperator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+#include <vector>
+
+namespace
+{
+
+// Input step per sample of the test ramps, well below one grid cell
+constexpr double kRampStep = 0.005;
+
+template <typename SampleType>
+class TestLane
+{
+public:
+    TestLane(const EverettTable& table)
+    {
+        model.prepare(1);
+        model.setSampleRate(1.0e12);
+        model.setTable(table);
+
+        // The demagnetised staircase of prepare() used the default table
+        model.reset();
+    }
+
+    // Ramps the input from where it is to target and returns the last output.
+    // Each output is appended to trace if given.
+    SampleType moveTo(double target, std::vector<SampleType>* trace = nullptr)
+    {
+        const int numSteps = std::max(1, (int) std::ceil(std::abs(target - input) / kRampStep - 1.0e-9));
+        const double start = input;
+        SampleType output = 0;
+
+        for (int step = 1; step <= numSteps; ++step)
+        {
+            input = step < numSteps ? start + (target - start) * step / numSteps : target;
+            output = model.processSample(0, static_cast<SampleType>(input));
+
+            if (trace != nullptr)
+                trace->push_back(output);
+        }
+
+        return output;
+    }
+
+    // Visits each extremum in turn
+    SampleType moveThrough(std::initializer_list<double> extrema)
+    {
+        SampleType output = 0;
+
+        for (double extremum : extrema)
+            output = moveTo(extremum);
+
+        return output;
+    }
+
+private:
+    PreisachOperator<SampleType> model;
+    double input = 0.0;
+};
+
+struct Result
+{
+    double worst = 0.0;
+
+    void compare(double a, double b) { worst = std::max(worst, std::abs(a - b)); }
+};
+
+// The nested minor loops inside (-1, 1) are wiped out once the input passes 1,
+// so the lane ends up where one that went straight from -1 to 1.8 does
+template <typename SampleType>
+Result checkWipingOut(const EverettTable& table)
+{
+    Result result;
+    TestLane<SampleType> looped(table), direct(table);
+
+    looped.moveThrough({ 3.0, -1.0, 1.0, 0.0, 0.8, 0.2, 0.6, 0.4 });
+    direct.moveThrough({ 3.0, -1.0 });
+
+    // Every later output follows from the same staircase too
+    for (double target : { 1.8, 1.2, 2.5, -0.5, 0.9 })
+        result.compare(looped.moveTo(target), direct.moveTo(target));
+
+    return result;
+}
+
+// Minor loops hanging off a rising and a falling branch come back to the output
+// they left from
+template <typename SampleType>
+Result checkLoopClosure(const EverettTable& table)
+{
+    Result result;
+    TestLane<SampleType> lane(table);
+
+    lane.moveThrough({ 3.0, -1.0 });
+    const SampleType atMaximum = lane.moveTo(1.0);
+    result.compare(lane.moveThrough({ -0.5, 1.0 }), atMaximum);
+
+    // A loop nested inside that one closes as well, and so does the outer loop
+    // around it afterwards
+    const SampleType atMinimum = lane.moveTo(-0.5);
+    const SampleType atInnerMaximum = lane.moveTo(0.5);
+    result.compare(lane.moveThrough({ 0.0, 0.5 }), atInnerMaximum);
+    result.compare(lane.moveTo(-0.5), atMinimum);
+    result.compare(lane.moveTo(1.0), atMaximum);
+
+    return result;
+}
+
+// The loop between 0.2 and 0.8 reached from positive saturation, and from a
+// staircase with two more turning points, differs only by an offset
+template <typename SampleType>
+Result checkCongruency(const EverettTable& table)
+{
+    Result result;
+    TestLane<SampleType> first(table), second(table);
+    std::vector<SampleType> firstLoop, secondLoop;
+
+    const SampleType firstStart = first.moveThrough({ 3.0, 0.2 });
+    const SampleType secondStart = second.moveThrough({ 3.0, -2.0, 1.0, 0.2 });
+
+    for (double target : { 0.8, 0.2 })
+    {
+        first.moveTo(target, &firstLoop);
+        second.moveTo(target, &secondLoop);
+    }
+
+    if (firstLoop.size() != secondLoop.size())
+        return { 1.0 };
+
+    for (size_t i = 0; i < firstLoop.size(); ++i)
+        result.compare(firstLoop[i] - firstStart, secondLoop[i] - secondStart);
+
+    return result;
+}
+
+template <typename SampleType>
+int runChecks(const char* typeName, double tolerance)
+{
+    int failures = 0;
+
+    for (int resolution : { EverettTable::kMinResolution, EverettTable::kDefaultResolution, EverettTable::kMaxResolution })
+    {
+        for (float width : { 0.2f, 0.8f })
+        {
+            EverettTable table;
+            table.build(resolution, width);
+
+            const struct
+            {
+                const char* name;
+                Result result;
+            } checks[] = {
+                { "wiping-out", checkWipingOut<SampleType>(table) },
+                { "loop closure", checkLoopClosure<SampleType>(table) },
+                { "congruency", checkCongruency<SampleType>(table) },
+            };
+
+            for (const auto& check : checks)
+            {
+                const bool passed = check.result.worst <= tolerance;
+                failures += passed ? 0 : 1;
+
+                std::printf("%-6s resolution %3d width %.1f %-12s: max difference %.3g (bound %.3g) %s\n",
+                            typeName, resolution, width, check.name, check.result.worst, tolerance,
+                            passed ? "ok" : "FAILED");
+            }
+        }
+    }
+
+    return failures;
+}
+
+} // namespace
+
+int main()
+{
+    // The DC blocker's leak over a few thousand samples, and float rounding in
+    // the running outputs
+    const int failures = runChecks<double>("double", 1.0e-6) + runChecks<float>("float", 1.0e-4);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+#include "RealtimeAllocationGuard.h"
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace RealtimeAllocationGuard
+{
+
+static std::atomic<int> violationCount { 0 };
+static std::atomic<ViolationHandler> violationHandler { nullptr };
+static thread_local int realtimeDepth = 0;
+
+void setViolationHandler(ViolationHandler handler)
+{
+    violationHandler.store(handler);
+}
+
+int getViolationCount()
+{
+    return violationCount.load();
+}
+
+void resetViolationCount()
+{
+    violationCount.store(0);
+}
+
+bool isInRealtimeSection()
+{
+    return realtimeDepth > 0;
+}
+
+#if TRANSFORMER_CHECK_RT_ALLOCATIONS
+
+void enterRealtimeSection()
+{
+    ++realtimeDepth;
+}
+
+void exitRealtimeSection()
+{
+    --realtimeDepth;
+}
+
+static void reportViolation(std::size_t numBytes)
+{
+    // The handler (or the assertion logger) may allocate itself, so the section
+    // is closed while it runs
+    const int depth = realtimeDepth;
+    realtimeDepth = 0;
+
+    violationCount.fetch_add(1);
+
+    if (auto handler = violationHandler.load())
+        handler(numBytes);
+    else
+        jassertfalse; // Heap allocation inside the render callback
+
+    realtimeDepth = depth;
+}
+
+static void* allocate(std::size_t numBytes)
+{
+    if (realtimeDepth > 0)
+        reportViolation(numBytes);
+
+    return std::malloc(numBytes == 0 ? 1 : numBytes);
+}
+
+static void* allocateAligned(std::size_t numBytes, std::size_t alignment)
+{
+    if (realtimeDepth > 0)
+        reportViolation(numBytes);
+
+    numBytes = numBytes == 0 ? alignment : numBytes;
+
+   #if JUCE_WINDOWS
+    return _aligned_malloc(numBytes, alignment);
+   #else
+    void* ptr = nullptr;
+    return posix_memalign(&ptr, juce::jmax(alignment, sizeof(void*)), numBytes) == 0 ? ptr : nullptr;
+   #endif
+}
+
+static void releaseAligned(void* ptr)
+{
+   #if JUCE_WINDOWS
+    _aligned_free(ptr);
+   #else
+    std::free(ptr);
+   #endif
+}
+
+#endif
+
+}
+
+#if TRANSFORMER_CHECK_RT_ALLOCATIONS
+
+using namespace RealtimeAllocationGuard;
+
+void* operator new(std::size_t numBytes)
+{
+    if (auto* ptr = allocate(numBytes))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t numBytes)
+{
+    return operator new(numBytes);
+}
+
+void* operator new(std::size_t numBytes, const std::nothrow_t&) noexcept
+{
+    return allocate(numBytes);
+}
+
+void* operator new[](std::size_t numBytes, const std::nothrow_t&) noexcept
+{
+    return allocate(numBytes);
+}
+
+void operator delete(void* ptr) noexcept                             { std::free(ptr); }
+void operator delete[](void* ptr) noexcept                           { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept                { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept              { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept      { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept    { std::free(ptr); }
+
+void* operator new(std::size_t numBytes, std::align_val_t alignment)
+{
+    if (auto* ptr = allocateAligned(numBytes, static_cast<std::size_t>(alignment)))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t numBytes, std::align_val_t alignment)
+{
+    return operator new(numBytes, alignment);
+}
+
+void* operator new(std::size_t numBytes, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(numBytes, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t numBytes, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(numBytes, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept                                { releaseAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept                              { releaseAligned(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept                   { releaseAligned(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept                 { releaseAligned(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept         { releaseAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept       { releaseAligned(ptr); }
+
+#endif
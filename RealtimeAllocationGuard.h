@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+
+// Debug hook that catches heap allocations made on the audio thread.
+//
+// processBlock opens a ScopedRealtimeSection. When the build defines
+// TRANSFORMER_CHECK_RT_ALLOCATIONS, the global operator new is replaced and any
+// allocation made while a section is open on the calling thread is reported to
+// the violation handler. The default handler hits jassertfalse. TransformerRegression
+// and TransformerBenchmark install a handler that only counts, and fail when
+// getViolationCount() is non-zero after rendering.
+//
+// Without TRANSFORMER_CHECK_RT_ALLOCATIONS (release builds, and the plugin, which
+// must not replace operator new inside a host process) the section is empty and
+// nothing is replaced.
+namespace RealtimeAllocationGuard
+{
+    using ViolationHandler = void (*)(std::size_t numBytes);
+
+    // Pass nullptr to restore the default handler
+    void setViolationHandler(ViolationHandler handler);
+
+    int getViolationCount();
+    void resetViolationCount();
+
+    // True while a realtime section is open on the calling thread
+    bool isInRealtimeSection();
+
+   #if TRANSFORMER_CHECK_RT_ALLOCATIONS
+    void enterRealtimeSection();
+    void exitRealtimeSection();
+
+    struct ScopedRealtimeSection
+    {
+        ScopedRealtimeSection()  { enterRealtimeSection(); }
+        ~ScopedRealtimeSection() { exitRealtimeSection(); }
+
+        ScopedRealtimeSection(const ScopedRealtimeSection&) = delete;
+        ScopedRealtimeSection& operator=(const ScopedRealtimeSection&) = delete;
+    };
+   #else
+    struct ScopedRealtimeSection
+    {
+        ScopedRealtimeSection() {}
+    };
+   #endif
+}
@@ -0,0 +1,207 @@
+#include "ShaperKernelsImpl.h"
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#if TRANSFORMER_X86 && defined(_MSC_VER) && ! defined(__clang__)
+ #include <intrin.h>
+ #include <immintrin.h>
+#endif
+
+namespace ShaperKernels
+{
+
+// One source for the float and double loops: exact (std::tanh) or fastTanh
+template <typename SampleType, bool exact>
+static void shapeLoop(SampleType* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew)
+{
+    const SampleType even = evenHarmonics, odd = oddHarmonics, asymmetry = skew;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const SampleType x = data[i];
+        const SampleType sign = (x >= SampleType(0)) ? SampleType(1) : SampleType(-1);
+        const SampleType absX = std::abs(x);
+
+        const SampleType oddTerm = exact ? std::tanh(absX * odd) : fastTanh(absX * odd);
+        const SampleType evenTerm = absX * absX * sign * even;
+
+        data[i] = (oddTerm + evenTerm) * (SampleType(1) + asymmetry * sign);
+    }
+}
+
+void shapeReference(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew)
+{
+    shapeLoop<float, true>(data, numSamples, evenHarmonics, oddHarmonics, skew);
+}
+
+void shapeReference(double* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew)
+{
+    shapeLoop<double, true>(data, numSamples, evenHarmonics, oddHarmonics, skew);
+}
+
+void Impl::shapeScalar(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew)
+{
+    shapeLoop<float, false>(data, numSamples, evenHarmonics, oddHarmonics, skew);
+}
+
+//==============================================================================
+#if TRANSFORMER_X86
+
+enum class CpuFeature
+{
+    avx2,
+    avx512
+};
+
+static bool cpuSupports(CpuFeature feature)
+{
+   #if defined(_MSC_VER) && ! defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+
+    if (info[0] < 7)
+        return false;
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+
+    if (! osxsave || ! fma)
+        return false;
+
+    // The OS has to save the upper halves of the YMM registers, and for
+    // AVX-512 the opmask and ZMM registers as well
+    const auto xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+
+    if (feature == CpuFeature::avx512)
+        return (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)) != 0;
+
+    return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+   #else
+    __builtin_cpu_init();
+
+    if (feature == CpuFeature::avx512)
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma");
+
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+   #endif
+}
+
+#endif
+
+//==============================================================================
+ShapeFunction getKernel(Isa isa)
+{
+    switch (isa)
+    {
+        case Isa::scalar: return Impl::shapeScalar;
+       #if TRANSFORMER_X86
+        case Isa::sse2:   return Impl::shapeSse2;
+       #if TRANSFORMER_KERNEL_AVX2
+        case Isa::avx2:   return cpuSupports(CpuFeature::avx2) ? Impl::shapeAvx2 : nullptr;
+       #endif
+       #if TRANSFORMER_KERNEL_AVX512
+        case Isa::avx512: return cpuSupports(CpuFeature::avx512) ? Impl::shapeAvx512 : nullptr;
+       #endif
+       #endif
+       #if TRANSFORMER_NEON
+        case Isa::neon:   return Impl::shapeNeon;
+       #endif
+        default:          return nullptr;
+    }
+}
+
+const char* getIsaName(Isa isa)
+{
+    switch (isa)
+    {
+        case Isa::sse2:   return "sse2";
+        case Isa::avx2:   return "avx2";
+        case Isa::avx512: return "avx512";
+        case Isa::neon:   return "neon";
+        case Isa::scalar:
+        default:          return "scalar";
+    }
+}
+
+bool findIsa(const char* name, Isa& isa)
+{
+    for (auto candidate : { Isa::scalar, Isa::sse2, Isa::avx2, Isa::avx512, Isa::neon })
+    {
+        if (std::strcmp(name, getIsaName(candidate)) == 0)
+        {
+            isa = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// A forced instruction set (environment first, then the build option) if it
+// runs here, otherwise the widest available
+static Isa chooseIsa()
+{
+    Isa isa = Isa::scalar;
+
+    if (const char* name = std::getenv("TRANSFORMER_ISA"))
+        if (findIsa(name, isa) && getKernel(isa) != nullptr)
+            return isa;
+
+   #ifdef TRANSFORMER_FORCE_ISA
+    if (findIsa(TRANSFORMER_FORCE_ISA, isa) && getKernel(isa) != nullptr)
+        return isa;
+   #endif
+
+    for (auto candidate : { Isa::avx512, Isa::avx2, Isa::sse2, Isa::neon })
+        if (getKernel(candidate) != nullptr)
+            return candidate;
+
+    return Isa::scalar;
+}
+
+// Picked on first use; forceIsa() may replace it later
+static std::atomic<Isa>& getActiveIsaSlot()
+{
+    static std::atomic<Isa> active { chooseIsa() };
+    return active;
+}
+
+static std::atomic<ShapeFunction>& getActiveKernelSlot()
+{
+    static std::atomic<ShapeFunction> kernel { getKernel(getActiveIsaSlot().load()) };
+    return kernel;
+}
+
+Isa getActiveIsa()
+{
+    return getActiveIsaSlot().load();
+}
+
+bool forceIsa(Isa isa)
+{
+    const auto kernel = getKernel(isa);
+
+    if (kernel == nullptr)
+        return false;
+
+    getActiveIsaSlot().store(isa);
+    getActiveKernelSlot().store(kernel);
+    return true;
+}
+
+void shape(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew)
+{
+    getActiveKernelSlot().load(std::memory_order_relaxed)(data, numSamples, evenHarmonics, oddHarmonics, skew);
+}
+
+void shape(double* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew)
+{
+    shapeLoop<double, false>(data, numSamples, evenHarmonics, oddHarmonics, skew);
+}
+
+}
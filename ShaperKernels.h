@@ -0,0 +1,75 @@
+#pragma once
+
+// Block kernels for the harmonic shaping stage of the transformer model.
+//
+// Every kernel computes, in place:
+//
+//     sign    = (x >= 0) ? 1 : -1
+//     shaped  = (tanh(|x| * odd) + |x|^2 * sign * even) * (1 + skew * sign)
+//
+// The vector kernels replace std::tanh with fastTanh() below. Each instruction
+// set is built in its own translation unit, and the widest one the running CPU
+// supports is picked on first use, unless one is forced through the
+// TRANSFORMER_ISA environment variable, the TRANSFORMER_FORCE_ISA build option
+// or forceIsa(). The double precision overloads
+// run one portable loop over the same interleaved data, which the compiler
+// vectorises for the target's baseline instruction set.
+namespace ShaperKernels
+{
+    // Inputs to the rational approximation are clamped to +/-kFastTanhClamp,
+    // where it reaches 1 to within float precision.
+    constexpr float kFastTanhClamp = 4.97f;
+
+    // Worst case |fastTanh(x) - std::tanh(x)| over all x. Below |x| = 3 the
+    // error is under 1e-6; most of the bound comes from the clamped tail.
+    constexpr float kFastTanhMaxError = 1.0e-4f;
+
+    // [7/6] Pade approximant of tanh, for float or double
+    template <typename SampleType>
+    inline SampleType fastTanh(SampleType x)
+    {
+        const SampleType clamp = static_cast<SampleType>(kFastTanhClamp);
+        x = x < -clamp ? -clamp : (x > clamp ? clamp : x);
+        const SampleType x2 = x * x;
+        const SampleType num = x * (SampleType(135135) + x2 * (SampleType(17325) + x2 * (SampleType(378) + x2)));
+        const SampleType den = SampleType(135135) + x2 * (SampleType(62370) + x2 * (SampleType(3150) + x2 * SampleType(28)));
+        return num / den;
+    }
+
+    enum class Isa
+    {
+        scalar,
+        sse2,
+        avx2,
+        avx512,
+        neon
+    };
+
+    using ShapeFunction = void (*)(float* data, int numSamples,
+                                   float evenHarmonics, float oddHarmonics, float skew);
+
+    // Reference implementation using std::tanh, used to validate the other paths
+    void shapeReference(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew);
+    void shapeReference(double* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew);
+
+    // Returns the kernel for an instruction set, or nullptr if it is not
+    // compiled in or not supported by the running CPU
+    ShapeFunction getKernel(Isa isa);
+
+    // Instruction set shape() runs: the forced one, or the best available
+    Isa getActiveIsa();
+    const char* getIsaName(Isa isa);
+
+    // Looks an instruction set up by its getIsaName() name
+    bool findIsa(const char* name, Isa& isa);
+
+    // Makes shape() use this instruction set from now on, for benchmarks and
+    // golden tests of each path. False (and no change) if it is not available.
+    bool forceIsa(Isa isa);
+
+    // Runs the kernel for getActiveIsa()
+    void shape(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew);
+
+    // Double precision path (fastTanh evaluated in double)
+    void shape(double* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew);
+}
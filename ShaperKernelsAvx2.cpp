@@ -0,0 +1,54 @@
+#include "ShaperKernelsImpl.h"
+
+// Built with AVX2 and FMA enabled (-mavx2 -mfma, /arch:AVX2)
+
+#if TRANSFORMER_X86 && TRANSFORMER_KERNEL_AVX2
+#include <immintrin.h>
+
+namespace ShaperKernels
+{
+namespace Impl
+{
+
+void shapeAvx2(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 clamp = _mm256_set1_ps(kFastTanhClamp);
+    const __m256 even = _mm256_set1_ps(evenHarmonics);
+    const __m256 odd = _mm256_set1_ps(oddHarmonics);
+    const __m256 sk = _mm256_set1_ps(skew);
+
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const __m256 x = _mm256_loadu_ps(data + i);
+        const __m256 sign = _mm256_or_ps(one, _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_LT_OQ), signBit));
+        const __m256 absX = _mm256_andnot_ps(signBit, x);
+
+        const __m256 t = _mm256_min_ps(_mm256_mul_ps(absX, odd), clamp);
+        const __m256 t2 = _mm256_mul_ps(t, t);
+        __m256 num = _mm256_add_ps(_mm256_set1_ps(378.0f), t2);
+        num = _mm256_fmadd_ps(t2, num, _mm256_set1_ps(17325.0f));
+        num = _mm256_fmadd_ps(t2, num, _mm256_set1_ps(135135.0f));
+        num = _mm256_mul_ps(t, num);
+        __m256 den = _mm256_fmadd_ps(t2, _mm256_set1_ps(28.0f), _mm256_set1_ps(3150.0f));
+        den = _mm256_fmadd_ps(t2, den, _mm256_set1_ps(62370.0f));
+        den = _mm256_fmadd_ps(t2, den, _mm256_set1_ps(135135.0f));
+        const __m256 oddTerm = _mm256_div_ps(num, den);
+
+        const __m256 evenTerm = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(absX, absX), sign), even);
+        const __m256 skewGain = _mm256_fmadd_ps(sk, sign, one);
+
+        _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_add_ps(oddTerm, evenTerm), skewGain));
+    }
+
+    shapeSse2(data + i, numSamples - i, evenHarmonics, oddHarmonics, skew);
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,54 @@
+#include "ShaperKernelsImpl.h"
+
+// Built with AVX-512F enabled (-mavx512f, /arch:AVX512)
+
+#if TRANSFORMER_X86 && TRANSFORMER_KERNEL_AVX512
+#include <immintrin.h>
+
+namespace ShaperKernels
+{
+namespace Impl
+{
+
+void shapeAvx512(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew)
+{
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 minusOne = _mm512_set1_ps(-1.0f);
+    const __m512 clamp = _mm512_set1_ps(kFastTanhClamp);
+    const __m512 even = _mm512_set1_ps(evenHarmonics);
+    const __m512 odd = _mm512_set1_ps(oddHarmonics);
+    const __m512 sk = _mm512_set1_ps(skew);
+
+    // The tail runs through the same body under a lane mask
+    for (int i = 0; i < numSamples; i += 16)
+    {
+        const int remaining = numSamples - i;
+        const __mmask16 lanes = remaining >= 16 ? (__mmask16) 0xffff : (__mmask16) ((1u << remaining) - 1u);
+
+        const __m512 x = _mm512_maskz_loadu_ps(lanes, data + i);
+        const __m512 sign = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, zero, _CMP_LT_OQ), one, minusOne);
+        const __m512 absX = _mm512_abs_ps(x);
+
+        const __m512 t = _mm512_min_ps(_mm512_mul_ps(absX, odd), clamp);
+        const __m512 t2 = _mm512_mul_ps(t, t);
+        __m512 num = _mm512_add_ps(_mm512_set1_ps(378.0f), t2);
+        num = _mm512_fmadd_ps(t2, num, _mm512_set1_ps(17325.0f));
+        num = _mm512_fmadd_ps(t2, num, _mm512_set1_ps(135135.0f));
+        num = _mm512_mul_ps(t, num);
+        __m512 den = _mm512_fmadd_ps(t2, _mm512_set1_ps(28.0f), _mm512_set1_ps(3150.0f));
+        den = _mm512_fmadd_ps(t2, den, _mm512_set1_ps(62370.0f));
+        den = _mm512_fmadd_ps(t2, den, _mm512_set1_ps(135135.0f));
+        const __m512 oddTerm = _mm512_div_ps(num, den);
+
+        const __m512 evenTerm = _mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(absX, absX), sign), even);
+        const __m512 skewGain = _mm512_fmadd_ps(sk, sign, one);
+
+        _mm512_mask_storeu_ps(data + i, lanes, _mm512_mul_ps(_mm512_add_ps(oddTerm, evenTerm), skewGain));
+    }
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+#include "ShaperKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+ #define TRANSFORMER_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+ #define TRANSFORMER_NEON 1
+#endif
+
+// Compiled with their instruction set enabled when CMake defines these
+#ifndef TRANSFORMER_KERNEL_AVX2
+ #define TRANSFORMER_KERNEL_AVX2 0
+#endif
+
+#ifndef TRANSFORMER_KERNEL_AVX512
+ #define TRANSFORMER_KERNEL_AVX512 0
+#endif
+
+// The kernel for every instruction set, one translation unit each
+// (ShaperKernels<Isa>.cpp). CMake builds each unit with its instruction set
+// enabled, and ShaperKernels.cpp only calls a kernel after checking the CPU.
+//
+// Those units must not instantiate any inline code they share with the rest of
+// the plugin (fastTanh, std::abs, ...): the linker may keep their copy for
+// everyone, and baseline CPUs would then run AVX instructions. They use
+// intrinsics only, and hand their tails to a baseline kernel.
+namespace ShaperKernels
+{
+namespace Impl
+{
+    void shapeScalar(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew);
+    void shapeSse2(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew);
+    void shapeAvx2(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew);
+    void shapeAvx512(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew);
+    void shapeNeon(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew);
+}
+}
@@ -0,0 +1,53 @@
+#include "ShaperKernelsImpl.h"
+
+// Baseline on AArch64, so this unit needs no extra flags
+
+#if TRANSFORMER_NEON
+#include <arm_neon.h>
+
+namespace ShaperKernels
+{
+namespace Impl
+{
+
+void shapeNeon(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t minusOne = vdupq_n_f32(-1.0f);
+    const float32x4_t clamp = vdupq_n_f32(kFastTanhClamp);
+    const float32x4_t even = vdupq_n_f32(evenHarmonics);
+    const float32x4_t odd = vdupq_n_f32(oddHarmonics);
+    const float32x4_t sk = vdupq_n_f32(skew);
+
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const float32x4_t x = vld1q_f32(data + i);
+        const float32x4_t sign = vbslq_f32(vcltq_f32(x, vdupq_n_f32(0.0f)), minusOne, one);
+        const float32x4_t absX = vabsq_f32(x);
+
+        const float32x4_t t = vminq_f32(vmulq_f32(absX, odd), clamp);
+        const float32x4_t t2 = vmulq_f32(t, t);
+        float32x4_t num = vaddq_f32(vdupq_n_f32(378.0f), t2);
+        num = vfmaq_f32(vdupq_n_f32(17325.0f), t2, num);
+        num = vfmaq_f32(vdupq_n_f32(135135.0f), t2, num);
+        num = vmulq_f32(t, num);
+        float32x4_t den = vfmaq_f32(vdupq_n_f32(3150.0f), t2, vdupq_n_f32(28.0f));
+        den = vfmaq_f32(vdupq_n_f32(62370.0f), t2, den);
+        den = vfmaq_f32(vdupq_n_f32(135135.0f), t2, den);
+        const float32x4_t oddTerm = vdivq_f32(num, den);
+
+        const float32x4_t evenTerm = vmulq_f32(vmulq_f32(vmulq_f32(absX, absX), sign), even);
+        const float32x4_t skewGain = vfmaq_f32(one, sk, sign);
+
+        vst1q_f32(data + i, vmulq_f32(vaddq_f32(oddTerm, evenTerm), skewGain));
+    }
+
+    shapeScalar(data + i, numSamples - i, evenHarmonics, oddHarmonics, skew);
+}
+
+}
+}
+
+#endif
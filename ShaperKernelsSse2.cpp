@@ -0,0 +1,55 @@
+#include "ShaperKernelsImpl.h"
+
+// Baseline on x86-64, so this unit needs no extra flags there
+
+#if TRANSFORMER_X86
+#include <emmintrin.h>
+
+namespace ShaperKernels
+{
+namespace Impl
+{
+
+void shapeSse2(float* data, int numSamples, float evenHarmonics, float oddHarmonics, float skew)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 clamp = _mm_set1_ps(kFastTanhClamp);
+    const __m128 even = _mm_set1_ps(evenHarmonics);
+    const __m128 odd = _mm_set1_ps(oddHarmonics);
+    const __m128 sk = _mm_set1_ps(skew);
+
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const __m128 x = _mm_loadu_ps(data + i);
+        const __m128 sign = _mm_or_ps(one, _mm_and_ps(_mm_cmplt_ps(x, zero), signBit));
+        const __m128 absX = _mm_andnot_ps(signBit, x);
+
+        // fastTanh on a non-negative argument only needs the upper clamp
+        const __m128 t = _mm_min_ps(_mm_mul_ps(absX, odd), clamp);
+        const __m128 t2 = _mm_mul_ps(t, t);
+        __m128 num = _mm_add_ps(_mm_set1_ps(378.0f), t2);
+        num = _mm_add_ps(_mm_set1_ps(17325.0f), _mm_mul_ps(t2, num));
+        num = _mm_add_ps(_mm_set1_ps(135135.0f), _mm_mul_ps(t2, num));
+        num = _mm_mul_ps(t, num);
+        __m128 den = _mm_add_ps(_mm_set1_ps(3150.0f), _mm_mul_ps(t2, _mm_set1_ps(28.0f)));
+        den = _mm_add_ps(_mm_set1_ps(62370.0f), _mm_mul_ps(t2, den));
+        den = _mm_add_ps(_mm_set1_ps(135135.0f), _mm_mul_ps(t2, den));
+        const __m128 oddTerm = _mm_div_ps(num, den);
+
+        const __m128 evenTerm = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(absX, absX), sign), even);
+        const __m128 skewGain = _mm_add_ps(one, _mm_mul_ps(sk, sign));
+
+        _mm_storeu_ps(data + i, _mm_mul_ps(_mm_add_ps(oddTerm, evenTerm), skewGain));
+    }
+
+    shapeScalar(data + i, numSamples - i, evenHarmonics, oddHarmonics, skew);
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,124 @@
+// Checks every shaper kernel the build and CPU provide against the std::tanh
+// reference, on ragged lengths and misaligned starts so every vector tail runs.
+// Run by CTest; exits with 1 on any failure.
+//
+// A kernel differs from the reference by the fastTanh error, scaled by the skew
+// gain (1 + |skew|), plus float rounding of the even term. Samples just outside
+// each block must stay untouched.
+
+#include "ShaperKernels.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+
+struct ShapeSettings
+{
+    float evenHarmonics;
+    float oddHarmonics;
+    float skew;
+};
+
+const ShapeSettings shapeSettings[] = {
+    { 0.3f, 1.0f, 0.1f },   // plugin defaults
+    { 0.0f, 0.0f, 0.0f },
+    { 1.0f, 1.0f, 0.5f },
+    { 1.0f, 1.0f, -0.5f },
+    { 0.7f, 0.2f, -0.3f },
+};
+
+// Inputs up to +/-12 cover the fastTanh clamp; every 17th is zero
+float testInput(std::uint32_t index)
+{
+    if (index % 17 == 0)
+        return 0.0f;
+
+    std::uint32_t hash = index * 2654435761u;
+    hash ^= hash >> 15;
+    hash *= 2246822519u;
+    hash ^= hash >> 13;
+    return ((float) (hash & 0xffffff) / (float) 0xffffff * 2.0f - 1.0f) * 12.0f;
+}
+
+// Largest deviation from the reference, less rounding slack, over the samples in
+// [offset, offset + length), or -1 if a sample outside them was written
+double checkBlock(int offset, int length, const ShapeSettings& settings)
+{
+    constexpr float guard = 123.0f;
+    std::vector<float> data((size_t) (offset + length + 16), guard);
+    std::vector<float> expected((size_t) length);
+
+    for (int i = 0; i < length; ++i)
+        data[(size_t) (offset + i)] = expected[(size_t) i] = testInput((std::uint32_t) (offset * 131 + length * 7 + i));
+
+    ShaperKernels::shapeReference(expected.data(), length, settings.evenHarmonics, settings.oddHarmonics, settings.skew);
+    ShaperKernels::shape(data.data() + offset, length, settings.evenHarmonics, settings.oddHarmonics, settings.skew);
+
+    for (int i = 0; i < (int) data.size(); ++i)
+        if ((i < offset || i >= offset + length) && data[(size_t) i] != guard)
+            return -1.0;
+
+    double worst = 0.0;
+
+    for (int i = 0; i < length; ++i)
+    {
+        const double reference = expected[(size_t) i];
+        const double error = std::abs((double) data[(size_t) (offset + i)] - reference);
+
+        // Rounding slack grows with the (mostly even term) output
+        worst = std::max(worst, error - 4.0 * FLT_EPSILON * std::abs(reference));
+    }
+
+    return worst;
+}
+
+} // namespace
+
+int main()
+{
+    const ShaperKernels::Isa isas[] = { ShaperKernels::Isa::scalar, ShaperKernels::Isa::sse2, ShaperKernels::Isa::avx2,
+                                        ShaperKernels::Isa::avx512, ShaperKernels::Isa::neon };
+    int failures = 0;
+
+    for (auto isa : isas)
+    {
+        const char* name = ShaperKernels::getIsaName(isa);
+
+        if (! ShaperKernels::forceIsa(isa))
+        {
+            std::printf("%-8s not available, skipped\n", name);
+            continue;
+        }
+
+        for (const auto& settings : shapeSettings)
+        {
+            const double bound = ShaperKernels::kFastTanhMaxError * (1.0 + std::abs(settings.skew));
+            double worst = 0.0;
+            bool wroteOutside = false;
+
+            for (int offset = 0; offset < 4; ++offset)
+            {
+                for (int length : { 0, 1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 100, 1000, 4099 })
+                {
+                    const double error = checkBlock(offset, length, settings);
+                    wroteOutside = wroteOutside || error < 0.0;
+                    worst = std::max(worst, error);
+                }
+            }
+
+            const bool passed = ! wroteOutside && worst <= bound;
+            failures += passed ? 0 : 1;
+
+            std::printf("%-8s even %.1f odd %.1f skew %+.1f: max error %.3g (bound %.3g)%s %s\n",
+                        name, settings.evenHarmonics, settings.oddHarmonics, settings.skew, worst, bound,
+                        wroteOutside ? ", wrote outside the block" : "", passed ? "ok" : "FAILED");
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include "ShaperTable.h"
+#include "ShaperKernels.h"
+#include <cmath>
+
+void ShaperTable::build(float evenHarmonics, float oddHarmonics, float skew)
+{
+    for (int i = 0; i < (int) mValues.size(); ++i)
+        mValues[(size_t) i] = -kInputRange + static_cast<float>(i - kGuardPoints) * kStep;
+
+    ShaperKernels::shapeReference(mValues.data(), (int) mValues.size(), evenHarmonics, oddHarmonics, skew);
+
+    mEvenHarmonics = evenHarmonics;
+    mOddHarmonics = oddHarmonics;
+    mSkew = skew;
+    mBuilt = true;
+}
+
+bool ShaperTable::matches(float evenHarmonics, float oddHarmonics, float skew) const
+{
+    return mBuilt && evenHarmonics == mEvenHarmonics && oddHarmonics == mOddHarmonics && skew == mSkew;
+}
+
+void ShaperTable::process(float* data, int numSamples, Interpolation interpolation) const
+{
+    processSamples(data, numSamples, interpolation);
+}
+
+void ShaperTable::process(double* data, int numSamples, Interpolation interpolation) const
+{
+    processSamples(data, numSamples, interpolation);
+}
+
+template <typename SampleType>
+void ShaperTable::processSamples(SampleType* data, int numSamples, Interpolation interpolation) const
+{
+    constexpr SampleType invStep = SampleType(1) / SampleType(kStep);
+    constexpr SampleType inputRange = kInputRange;
+    const float* values = mValues.data() + kGuardPoints;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const SampleType x = data[i];
+
+        if (! (std::abs(x) < inputRange))
+        {
+            ShaperKernels::shapeReference(data + i, 1, mEvenHarmonics, mOddHarmonics, mSkew);
+            continue;
+        }
+
+        const SampleType position = (x + inputRange) * invStep;
+        const int index = static_cast<int>(position);
+        const SampleType t = position - static_cast<SampleType>(index);
+        const float* p = values + index;
+
+        // The cubic would reach across the kink at zero, so its two neighbouring
+        // intervals stay linear
+        if (interpolation == Interpolation::linear || index == kNumIntervals / 2 - 1 || index == kNumIntervals / 2)
+        {
+            data[i] = p[0] + (SampleType(p[1]) - p[0]) * t;
+        }
+        else
+        {
+            // Catmull-Rom through p[-1], p[0], p[1], p[2]
+            const SampleType a = SampleType(p[1]) - p[-1];
+            const SampleType b = SampleType(2) * p[-1] - SampleType(5) * p[0] + SampleType(4) * p[1] - p[2];
+            const SampleType c = SampleType(3) * (SampleType(p[0]) - p[1]) + p[2] - p[-1];
+            data[i] = p[0] + SampleType(0.5) * t * (a + t * (b + t * c));
+        }
+    }
+}
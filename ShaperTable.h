@@ -0,0 +1,46 @@
+#pragma once
+#include <array>
+
+// Precomputed harmonic shaping curve (see ShaperKernels) over a bounded input
+// range, read back with linear or cubic (Catmull-Rom) interpolation. Inputs
+// outside the range fall back to the exact curve.
+//
+// The grid has a node at zero, where the skew term puts a kink in the curve, and
+// the cubic falls back to linear in the two intervals touching it. Worst case
+// error against ShaperKernels::shapeReference is about 1e-5 for both modes.
+class ShaperTable
+{
+public:
+    static constexpr int kNumIntervals = 2048;
+    static constexpr float kInputRange = 8.0f;
+
+    enum class Interpolation
+    {
+        linear,
+        cubic
+    };
+
+    // Samples the curve for these settings; allocation-free, safe on any thread
+    void build(float evenHarmonics, float oddHarmonics, float skew);
+
+    // True if the table holds exactly these settings
+    bool matches(float evenHarmonics, float oddHarmonics, float skew) const;
+
+    // The table itself is float; double data is interpolated in double
+    void process(float* data, int numSamples, Interpolation interpolation) const;
+    void process(double* data, int numSamples, Interpolation interpolation) const;
+
+private:
+    template <typename SampleType>
+    void processSamples(SampleType* data, int numSamples, Interpolation interpolation) const;
+
+    // One guard point below -kInputRange and two above +kInputRange for the cubic
+    static constexpr int kGuardPoints = 1;
+    static constexpr float kStep = 2.0f * kInputRange / kNumIntervals;
+
+    std::array<float, kNumIntervals + 1 + 3> mValues {};
+    float mEvenHarmonics = 0.0f;
+    float mOddHarmonics = 0.0f;
+    float mSkew = 0.0f;
+    bool mBuilt = false;
+};
@@ -0,0 +1,102 @@
+#include "ShaperTableBuilder.h"
+
+ShaperTableBuilder::ShaperTableBuilder(int numTargets)
+    : juce::Thread("Shaper table builder"),
+      targets((size_t) juce::jmax(1, numTargets))
+{
+}
+
+ShaperTableBuilder::~ShaperTableBuilder()
+{
+    stop();
+}
+
+void ShaperTableBuilder::start()
+{
+    if (! isThreadRunning())
+        startThread();
+}
+
+void ShaperTableBuilder::stop()
+{
+    stopThread(1000);
+}
+
+void ShaperTableBuilder::request(int target, float evenHarmonics, float oddHarmonics, float skew)
+{
+    jassert(target >= 0 && target < (int) targets.size());
+    auto& state = targets[(size_t) target];
+
+    // The audio thread requests the live target every block, so unchanged
+    // settings return here without touching the thread's event
+    if (state.requested.load(std::memory_order_relaxed)
+        && state.requestedEvenHarmonics.load(std::memory_order_relaxed) == evenHarmonics
+        && state.requestedOddHarmonics.load(std::memory_order_relaxed) == oddHarmonics
+        && state.requestedSkew.load(std::memory_order_relaxed) == skew)
+        return;
+
+    state.requestedEvenHarmonics.store(evenHarmonics, std::memory_order_relaxed);
+    state.requestedOddHarmonics.store(oddHarmonics, std::memory_order_relaxed);
+    state.requestedSkew.store(skew, std::memory_order_relaxed);
+    state.requested.store(true, std::memory_order_release);
+    state.dirty.store(true, std::memory_order_release);
+    notify();
+}
+
+const ShaperTable* ShaperTableBuilder::acquire(int target)
+{
+    jassert(target >= 0 && target < (int) targets.size());
+    auto& state = targets[(size_t) target];
+    const int pending = state.pendingSlot.load(std::memory_order_acquire);
+
+    if (pending >= 0)
+    {
+        state.activeSlot.store(pending, std::memory_order_relaxed);
+
+        // Hands the old slot back to the builder, which skipped any newer
+        // request while the slot was taken. Sequentially consistent, so either
+        // this sees that request or the builder sees the free slot.
+        state.pendingSlot.store(-1, std::memory_order_seq_cst);
+
+        if (state.dirty.load(std::memory_order_seq_cst))
+            notify();
+    }
+
+    const int active = state.activeSlot.load(std::memory_order_relaxed);
+    return active >= 0 ? &state.tables[(size_t) active] : nullptr;
+}
+
+void ShaperTableBuilder::run()
+{
+    while (! threadShouldExit())
+    {
+        for (auto& state : targets)
+        {
+            // Wait until the audio thread has taken the last table before reusing
+            // its slot; acquire() wakes the thread again then
+            if (state.pendingSlot.load(std::memory_order_seq_cst) >= 0)
+                continue;
+
+            // Cleared before reading the settings, so a request landing meanwhile
+            // builds again
+            if (! state.dirty.exchange(false, std::memory_order_seq_cst))
+                continue;
+
+            const int active = state.activeSlot.load(std::memory_order_relaxed);
+            const float evenHarmonics = state.requestedEvenHarmonics.load(std::memory_order_relaxed);
+            const float oddHarmonics = state.requestedOddHarmonics.load(std::memory_order_relaxed);
+            const float skew = state.requestedSkew.load(std::memory_order_relaxed);
+
+            if (active < 0 || ! state.tables[(size_t) active].matches(evenHarmonics, oddHarmonics, skew))
+            {
+                const int slot = active == 0 ? 1 : 0;
+                state.tables[(size_t) slot].build(evenHarmonics, oddHarmonics, skew);
+                state.pendingSlot.store(slot, std::memory_order_release);
+            }
+        }
+
+        // Until request() or acquire() has more work; a notify() that came
+        // during the pass above is not lost
+        wait(-1);
+    }
+}
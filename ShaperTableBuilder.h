@@ -0,0 +1,62 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "ShaperTable.h"
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Builds ShaperTables on a background thread and hands them to the audio thread
+// through a lock-free double buffer per target.
+//
+// Each target is an independent table the caller requests settings for, e.g. one
+// following the live parameters and one held ready for each snapshot. Targets
+// that were never requested are not built.
+//
+// The audio thread reads a target's active slot. The builder only writes the
+// other slot, and only while no finished table is waiting to be picked up, so the
+// two threads never touch the same table and neither ever blocks on the other.
+//
+// The thread sleeps until request() changes a target's settings, or until the
+// audio thread picks up a table while a newer request is waiting for its slot.
+class ShaperTableBuilder : private juce::Thread
+{
+public:
+    explicit ShaperTableBuilder(int numTargets = 1);
+    ~ShaperTableBuilder() override;
+
+    // Message thread
+    void start();
+    void stop();
+
+    // Any thread
+    bool isRunning() const { return isThreadRunning(); }
+
+    // Any thread: settings the target's next table should be built for. Wakes the
+    // builder only when they differ from the last request.
+    void request(int target, float evenHarmonics, float oddHarmonics, float skew);
+
+    // Audio thread: takes a newly published table for the target if there is one
+    // and returns its current table, or nullptr until the first one is ready
+    const ShaperTable* acquire(int target);
+
+private:
+    void run() override;
+
+    struct Target
+    {
+        std::array<ShaperTable, 2> tables;
+        std::atomic<int> activeSlot { -1 };     // slot the audio thread reads, -1 before the first table
+        std::atomic<int> pendingSlot { -1 };    // finished slot waiting for the audio thread
+
+        std::atomic<bool> requested { false };
+        std::atomic<bool> dirty { false };      // requested settings the builder hasn't looked at yet
+        std::atomic<float> requestedEvenHarmonics { 0.3f };
+        std::atomic<float> requestedOddHarmonics { 1.0f };
+        std::atomic<float> requestedSkew { 0.1f };
+    };
+
+    // Sized once at construction, never resized
+    std::vector<Target> targets;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ShaperTableBuilder)
+};
@@ -0,0 +1,119 @@
+#include "StageProfiler.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+const char* StageProfiler::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+        case Stage::block:      return "block";
+        case Stage::split:      return "split";
+        case Stage::upsample:   return "upsample";
+        case Stage::hysteresis: return "hysteresis";
+        case Stage::shaping:    return "shaping";
+        case Stage::downsample: return "downsample";
+        case Stage::mix:        return "mix";
+        case Stage::numStages:
+        default:                return "";
+    }
+}
+
+double StageProfiler::getCounterFrequency()
+{
+    static const double frequency = []
+    {
+        const auto ticksStart = juce::Time::getHighResolutionTicks();
+        const auto counterStart = readCounter();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const auto counterEnd = readCounter();
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - ticksStart);
+
+        return seconds > 0.0 ? (double) (counterEnd - counterStart) / seconds : 1.0;
+    }();
+
+    return frequency;
+}
+
+juce::uint64 StageProfiler::Histogram::getPercentileTicks(double fraction) const
+{
+    const auto target = (juce::uint64) std::ceil(juce::jlimit(0.0, 1.0, fraction) * (double) count);
+    juce::uint64 seen = 0;
+
+    for (int bucket = 0; bucket < kNumBuckets; ++bucket)
+    {
+        seen += buckets[(size_t) bucket];
+
+        if (seen >= target && seen > 0)
+            return juce::jmin(maxTicks, (juce::uint64) 2 << bucket);
+    }
+
+    return maxTicks;
+}
+
+void StageProfiler::reset()
+{
+    for (auto& counters : stages)
+    {
+        counters.count.store(0);
+        counters.totalTicks.store(0);
+        counters.maxTicks.store(0);
+
+        for (auto& bucket : counters.buckets)
+            bucket.store(0);
+    }
+}
+
+StageProfiler::Histogram StageProfiler::getHistogram(Stage stage) const
+{
+    const auto& counters = stages[(size_t) stage];
+    Histogram histogram;
+    histogram.count = counters.count.load(std::memory_order_relaxed);
+    histogram.totalTicks = counters.totalTicks.load(std::memory_order_relaxed);
+    histogram.maxTicks = counters.maxTicks.load(std::memory_order_relaxed);
+
+    for (size_t bucket = 0; bucket < histogram.buckets.size(); ++bucket)
+        histogram.buckets[bucket] = counters.buckets[bucket].load(std::memory_order_relaxed);
+
+    return histogram;
+}
+
+juce::var StageProfiler::toVar() const
+{
+    const double microsecondsPerTick = 1.0e6 / getCounterFrequency();
+    auto* root = new juce::DynamicObject();
+    root->setProperty("enabled", isEnabled());
+    root->setProperty("counterHz", getCounterFrequency());
+
+    for (int i = 0; i < kNumStages; ++i)
+    {
+        const auto histogram = getHistogram((Stage) i);
+        const auto p50 = histogram.getPercentileTicks(0.5);
+        const auto p99 = histogram.getPercentileTicks(0.99);
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("count", (juce::int64) histogram.count);
+        entry->setProperty("meanTicks", histogram.getMeanTicks());
+        entry->setProperty("p50Ticks", (juce::int64) p50);
+        entry->setProperty("p99Ticks", (juce::int64) p99);
+        entry->setProperty("maxTicks", (juce::int64) histogram.maxTicks);
+        entry->setProperty("meanUs", histogram.getMeanTicks() * microsecondsPerTick);
+        entry->setProperty("p99Us", (double) p99 * microsecondsPerTick);
+        entry->setProperty("maxUs", (double) histogram.maxTicks * microsecondsPerTick);
+
+        juce::Array<juce::var> buckets;
+
+        for (auto bucket : histogram.buckets)
+            buckets.add((juce::int64) bucket);
+
+        entry->setProperty("log2Buckets", buckets);
+        root->setProperty(getStageName((Stage) i), juce::var(entry));
+    }
+
+    return juce::var(root);
+}
+
+juce::String StageProfiler::toJson() const
+{
+    return juce::JSON::toString(toVar());
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "StageRecorder.h"
+#include <array>
+
+// Per-stage timing of the signal path. Built with TRANSFORMER_PROFILE_STAGES=1
+// (the CMake option of the same name), every TRANSFORMER_PROFILE_STAGE scope adds
+// its duration in counter ticks (the TSC on x86, so CPU cycles at the nominal
+// clock) to a log2 histogram for its stage. Without it the macro expands to
+// nothing and the audio thread never touches the profiler.
+//
+// The audio thread is the only writer (through StageRecorder, which the DSP
+// classes see) and uses relaxed atomic loads and stores, so any thread can read
+// the histograms at any time without locks. A reader may see a stage's count
+// and buckets from neighbouring blocks.
+class StageProfiler : public StageRecorder
+{
+public:
+    static const char* getStageName(Stage stage);
+
+    // Counter ticks per second, measured once against the wall clock (takes about
+    // 20 ms on the first call; never call it from the audio thread)
+    static double getCounterFrequency();
+
+    struct Histogram
+    {
+        juce::uint64 count = 0;
+        juce::uint64 totalTicks = 0;
+        juce::uint64 maxTicks = 0;
+        std::array<juce::uint64, kNumBuckets> buckets {};
+
+        double getMeanTicks() const { return count > 0 ? (double) totalTicks / (double) count : 0.0; }
+
+        // Upper bound of the bucket holding this fraction (0..1) of the samples
+        juce::uint64 getPercentileTicks(double fraction) const;
+    };
+
+    // Only while the audio thread isn't recording, e.g. in prepareToPlay
+    void reset();
+
+    Histogram getHistogram(Stage stage) const;
+
+    // Every stage's count, mean, p50, p99 and max in ticks and microseconds
+    juce::var toVar() const;
+    juce::String toJson() const;
+};
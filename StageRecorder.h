@@ -0,0 +1,124 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if TRANSFORMER_PROFILE_STAGES
+ #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h>
+ #elif defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+ #endif
+#endif
+
+// The audio thread's side of the per-stage timing (see StageProfiler): the
+// stages, the lock-free counters and the TRANSFORMER_PROFILE_STAGE scope. Needs
+// nothing from JUCE, so the DSP classes that time their own stages stay
+// JUCE-free; reading and reporting the histograms is StageProfiler's job.
+class StageRecorder
+{
+public:
+    enum class Stage
+    {
+        block,      // the whole of TransformerEngine::process
+        split,      // crossover
+        upsample,
+        hysteresis, // drive, interleaving and the history or Preisach stage
+        shaping,    // harmonic shaping and deinterleaving
+        downsample,
+        mix,        // band sum and output gain
+        numStages
+    };
+
+    static constexpr int kNumStages = (int) Stage::numStages;
+    static constexpr int kNumBuckets = 32; // bucket b holds durations in [2^b, 2^(b+1)) ticks
+
+    static constexpr bool isEnabled()
+    {
+       #if TRANSFORMER_PROFILE_STAGES
+        return true;
+       #else
+        return false;
+       #endif
+    }
+
+    static std::uint64_t readCounter() noexcept
+    {
+       #if TRANSFORMER_PROFILE_STAGES && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+        return (std::uint64_t) __rdtsc();
+       #elif TRANSFORMER_PROFILE_STAGES && defined(__aarch64__)
+        std::uint64_t ticks;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (ticks));
+        return ticks;
+       #else
+        return (std::uint64_t) std::chrono::steady_clock::now().time_since_epoch().count();
+       #endif
+    }
+
+    // Audio thread only
+    void record(Stage stage, std::uint64_t ticks) noexcept
+    {
+        auto& counters = stages[(size_t) stage];
+
+        int bucket = 0;
+
+        while (bucket < kNumBuckets - 1 && (ticks >> (bucket + 1)) != 0)
+            ++bucket;
+
+        const auto add = [](std::atomic<std::uint64_t>& counter, std::uint64_t value)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        };
+
+        add(counters.buckets[(size_t) bucket], 1);
+        add(counters.totalTicks, ticks);
+        add(counters.count, 1);
+
+        if (ticks > counters.maxTicks.load(std::memory_order_relaxed))
+            counters.maxTicks.store(ticks, std::memory_order_relaxed);
+    }
+
+    // Records the time from construction to destruction; a null recorder records nothing
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(StageRecorder* recorderToUse, Stage stageToTime) noexcept
+            : recorder(recorderToUse), stage(stageToTime), start(recorder != nullptr ? readCounter() : 0) {}
+
+        ~ScopedTimer()
+        {
+            if (recorder != nullptr)
+                recorder->record(stage, readCounter() - start);
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        StageRecorder* recorder;
+        Stage stage;
+        std::uint64_t start;
+    };
+
+protected:
+    struct Counters
+    {
+        std::atomic<std::uint64_t> count { 0 };
+        std::atomic<std::uint64_t> totalTicks { 0 };
+        std::atomic<std::uint64_t> maxTicks { 0 };
+        std::array<std::atomic<std::uint64_t>, kNumBuckets> buckets {};
+    };
+
+    std::array<Counters, kNumStages> stages;
+};
+
+#define TRANSFORMER_STAGE_TIMER_NAME_(line) stageTimer##line
+#define TRANSFORMER_STAGE_TIMER_NAME(line) TRANSFORMER_STAGE_TIMER_NAME_(line)
+
+#if TRANSFORMER_PROFILE_STAGES
+ #define TRANSFORMER_PROFILE_STAGE(recorder, stage) \
+    StageRecorder::ScopedTimer TRANSFORMER_STAGE_TIMER_NAME (__LINE__) (recorder, StageRecorder::Stage::stage)
+#else
+ #define TRANSFORMER_PROFILE_STAGE(recorder, stage)
+#endif
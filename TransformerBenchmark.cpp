@@ -0,0 +1,833 @@
+// Standalone benchmark for the DSP hot path.
+//
+//   TransformerBenchmark [options]
+//
+//   --filter=<text>        Only run benchmarks whose name contains text
+//   --min-time=<seconds>   Minimum measuring time per case (default: 0.05)
+//   --repetitions=<n>      Measurements per case, the median is reported (default: 5)
+//   --format=<table|json|csv>  Output format (default: table)
+//   --output=<file>        Write results to a file instead of stdout
+//   --quick                Reduced matrix for smoke runs
+//   --isa=<name>           Shaper kernel to use: scalar, sse2, avx2, avx512 or neon
+//                          (default: the best one for this CPU)
+//
+// Every case reports ns per sample frame (one sample on every channel), the same
+// cost per channel, sample frames per second, and the realtime headroom: how many instances of the case
+// fit on one core at its block size and sample rate. Builds with
+// TRANSFORMER_PROFILE_STAGES also add the processBlock cases' per-stage timing
+// histograms to the JSON output. Builds with TRANSFORMER_CHECK_RT_ALLOCATIONS
+// (Debug) exit with 1 if any processBlock case allocated on the audio thread.
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_dsp/juce_dsp.h>
+#include "PluginProcessor.h"
+#include "CrossoverEngine.h"
+#include "EverettTable.h"
+#include "PreisachModelBank.h"
+#include "RealtimeAllocationGuard.h"
+#include "ShaperKernels.h"
+#include "ShaperTable.h"
+#include "StageProfiler.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <type_traits>
+
+namespace
+{
+
+// Baseline for the model.* cases: the single-lane decaying-history model the
+// plugin ran before PreisachModelBank (a weighted history average into the
+// shaper, std::tanh in the per-sample path). Kept here only so those cases stay
+// comparable across versions; the plugin no longer uses it.
+class LegacyTransformerModel
+{
+public:
+    // Upper bound for the number of history taps; storage is fixed so the
+    // audio thread never touches the heap
+    static constexpr int kMaxHistoryDepth = 64;
+    static constexpr int kDefaultHistoryDepth = 10;
+    
+    LegacyTransformerModel() 
+    {
+        // Initialize with default values
+        rebuildDecayWeights();
+        reset();
+    }
+    
+    void reset()
+    {
+        // Clear history and reset state
+        mPreviousInput = 0.0f;
+        mHistoryState.fill(0.0f);
+        mWritePos = 0;
+    }
+    
+    // Number of history points used for hysteresis (clamped to 1..kMaxHistoryDepth)
+    void setHistoryDepth(int depth)
+    {
+        depth = juce::jlimit(1, kMaxHistoryDepth, depth);
+        
+        if (depth == mHistoryDepth)
+            return;
+        
+        mHistoryDepth = depth;
+        rebuildDecayWeights();
+        reset();
+    }
+    
+    int getHistoryDepth() const { return mHistoryDepth; }
+    
+    void setDensityParams(float width, float skew)
+    {
+        mSkew = skew;
+        
+        // Decay weights only depend on the width, so only rebuild when it moves
+        if (width != mWidth)
+        {
+            mWidth = width;
+            rebuildDecayWeights();
+        }
+    }
+    
+    void setHarmonics(float evenHarmonics, float oddHarmonics)
+    {
+        mEvenHarmonics = evenHarmonics;
+        mOddHarmonics = oddHarmonics;
+    }
+    
+    void setDrive(float drive)
+    {
+        mDrive = drive;
+    }
+    
+    // Block version of process() using the drive set with setDrive(). The
+    // history stage runs sample by sample, then the whole block is shaped in
+    // one pass by the SIMD kernel for this CPU. input and output may alias.
+    void processBlock(const float* input, float* output, int numSamples)
+    {
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            mPreviousInput = input[sample];
+            const float x = mPreviousInput * mDrive;
+            
+            mWritePos = (mWritePos == 0 ? mHistoryDepth : mWritePos) - 1;
+            mHistoryState[(size_t) mWritePos] = x;
+            mHistoryState[(size_t) (mWritePos + mHistoryDepth)] = x;
+            
+            const float* window = mHistoryState.data() + mWritePos;
+            float sum = 0.0f;
+            
+            for (int i = 0; i < mHistoryDepth; ++i)
+                sum += window[i] * mDecayWeights[(size_t) i];
+            
+            output[sample] = sum;
+        }
+        
+        ShaperKernels::shape(output, numSamples, mEvenHarmonics, mOddHarmonics, mSkew);
+    }
+    
+    float process(float input, float drive)
+    {
+        // Apply drive and input conditioning
+        float x = input * drive;
+        
+        // Update history: the newest sample moves one slot back in the ring and is
+        // mirrored depth slots ahead, so the window [mWritePos, mWritePos + depth)
+        // is always contiguous with the newest sample first
+        mWritePos = (mWritePos == 0 ? mHistoryDepth : mWritePos) - 1;
+        mHistoryState[(size_t) mWritePos] = x;
+        mHistoryState[(size_t) (mWritePos + mHistoryDepth)] = x;
+        
+        // Weighted sum of history to simulate hysteresis (weights are pre-normalised)
+        const float* window = mHistoryState.data() + mWritePos;
+        float output = 0.0f;
+        
+        for (int i = 0; i < mHistoryDepth; ++i)
+            output += window[i] * mDecayWeights[(size_t) i];
+        
+        // Apply nonlinear shaping for harmonics
+        float sign = (output >= 0.0f) ? 1.0f : -1.0f;
+        float absOutput = std::abs(output);
+        
+        // Tanh for odd harmonics, squared term for even harmonics
+        float oddTerm = std::tanh(absOutput * mOddHarmonics);
+        float evenTerm = absOutput * absOutput * sign * mEvenHarmonics;
+        
+        // Combine and apply skew for asymmetrical distortion
+        float shaped = (oddTerm + evenTerm) * (1.0f + mSkew * sign);
+        
+        // Store for next iteration
+        mPreviousInput = input;
+        
+        return shaped;
+    }
+    
+private:
+    // exp(-i * width) for each tap, folded together with the normalisation factor
+    void rebuildDecayWeights()
+    {
+        float weightSum = 0.0f;
+        
+        for (int i = 0; i < mHistoryDepth; ++i)
+        {
+            mDecayWeights[(size_t) i] = std::exp(-static_cast<float>(i) * mWidth);
+            weightSum += mDecayWeights[(size_t) i];
+        }
+        
+        const float norm = weightSum > 0.0f ? 1.0f / weightSum : 0.0f;
+        
+        for (int i = 0; i < mHistoryDepth; ++i)
+            mDecayWeights[(size_t) i] *= norm;
+    }
+    
+    // Ring buffer stored twice over so the dot product never has to wrap
+    std::array<float, 2 * kMaxHistoryDepth> mHistoryState {};
+    std::array<float, kMaxHistoryDepth> mDecayWeights {};
+    int mHistoryDepth = kDefaultHistoryDepth;
+    int mWritePos = 0;
+    float mPreviousInput = 0.0f;
+    float mDrive = 1.0f;
+    float mWidth = 0.2f;      // Controls how quickly past states decay
+    float mSkew = 0.1f;       // Controls asymmetry of saturation
+    float mEvenHarmonics = 0.3f; // Controls amount of even harmonics
+    float mOddHarmonics = 1.0f;  // Controls amount of odd harmonics
+};
+
+struct Preset
+{
+    const char* name;
+    float drive, evenHarmonics, oddHarmonics, hysteresis, asymmetry;
+    int oversampling; // choice index, 0 = off
+};
+
+const Preset presets[] =
+{
+    { "default", 1.0f,  0.3f, 1.0f, 0.2f,  0.1f, 1 },
+    { "hot",     10.0f, 1.0f, 1.0f, 0.05f, 0.3f, 1 },
+    { "os-off",  1.0f,  0.3f, 1.0f, 0.2f,  0.1f, 0 },
+    { "os-8x",   1.0f,  0.3f, 1.0f, 0.2f,  0.1f, 3 },
+};
+
+struct Case
+{
+    juce::String benchmark;
+    const Preset* preset;
+    double sampleRate;
+    int blockSize;
+    int numChannels;
+};
+
+struct Result
+{
+    Case benchmarkCase;
+    double nsPerSample;
+    juce::var stages; // StageProfiler::toVar() for processBlock cases in profiling builds
+
+    double getSamplesPerSecond() const  { return 1.0e9 / nsPerSample; }
+    double getNsPerChannel() const      { return nsPerSample / benchmarkCase.numChannels; }
+
+    // How many instances could run on one core before missing the deadline
+    double getInstancesPerCore() const  { return benchmarkCase.sampleRate > 0.0 ? 1.0e9 / (nsPerSample * benchmarkCase.sampleRate) : 0.0; }
+};
+
+struct Options
+{
+    juce::String filter;
+    double minTime = 0.05;
+    int repetitions = 5;
+    bool quick = false;
+};
+
+// Deterministic programme-like input: a couple of partials plus noise around -6 dBFS
+void fillTestSignal(juce::AudioBuffer<float>& buffer, double sampleRate)
+{
+    juce::Random random(1234);
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        auto* data = buffer.getWritePointer(channel);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            const double t = i / sampleRate;
+            data[i] = (float) (0.3 * std::sin(juce::MathConstants<double>::twoPi * 110.0 * t)
+                               + 0.15 * std::sin(juce::MathConstants<double>::twoPi * 2500.0 * t + channel))
+                      + 0.05f * (random.nextFloat() * 2.0f - 1.0f);
+        }
+    }
+}
+
+void setParameter(TransformerAudioProcessor& processor, const juce::String& id, float value)
+{
+    if (auto* parameter = processor.parameters.getParameter(id))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+// Runs processOneBlock until minTime has passed, repetitions times, and returns
+// the median ns per sample frame
+double measure(const Options& options, int blockSize, const std::function<void()>& processOneBlock)
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Warm up caches, branch predictors and lazily built tables
+    for (int i = 0; i < 16; ++i)
+        processOneBlock();
+
+    std::vector<double> timings;
+
+    for (int repetition = 0; repetition < options.repetitions; ++repetition)
+    {
+        juce::int64 numBlocks = 0;
+        const auto start = Clock::now();
+        auto elapsed = Clock::duration::zero();
+
+        do
+        {
+            for (int i = 0; i < 8; ++i)
+                processOneBlock();
+
+            numBlocks += 8;
+            elapsed = Clock::now() - start;
+        }
+        while (std::chrono::duration<double>(elapsed).count() < options.minTime);
+
+        const double ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        timings.push_back(ns / (double) (numBlocks * blockSize));
+    }
+
+    std::sort(timings.begin(), timings.end());
+    return timings[timings.size() / 2];
+}
+
+//==============================================================================
+double benchmarkModelProcess(const Options& options, const Case& c)
+{
+    juce::AudioBuffer<float> input(c.numChannels * 2, c.blockSize);
+    fillTestSignal(input, c.sampleRate);
+    std::vector<LegacyTransformerModel> models((size_t) (c.numChannels * 2));
+
+    for (auto& model : models)
+    {
+        model.setDensityParams(c.preset->hysteresis, c.preset->asymmetry);
+        model.setHarmonics(c.preset->evenHarmonics, c.preset->oddHarmonics);
+    }
+
+    float sink = 0.0f;
+
+    const double ns = measure(options, c.blockSize, [&]
+    {
+        for (int lane = 0; lane < input.getNumChannels(); ++lane)
+        {
+            const float* data = input.getReadPointer(lane);
+            auto& model = models[(size_t) lane];
+
+            for (int i = 0; i < c.blockSize; ++i)
+                sink += model.process(data[i], c.preset->drive);
+        }
+    });
+
+    juce::ignoreUnused(sink);
+    return ns;
+}
+
+double benchmarkModelProcessBlock(const Options& options, const Case& c)
+{
+    juce::AudioBuffer<float> input(c.numChannels * 2, c.blockSize);
+    juce::AudioBuffer<float> output(c.numChannels * 2, c.blockSize);
+    fillTestSignal(input, c.sampleRate);
+    std::vector<LegacyTransformerModel> models((size_t) (c.numChannels * 2));
+
+    for (auto& model : models)
+    {
+        model.setDensityParams(c.preset->hysteresis, c.preset->asymmetry);
+        model.setHarmonics(c.preset->evenHarmonics, c.preset->oddHarmonics);
+        model.setDrive(c.preset->drive);
+    }
+
+    return measure(options, c.blockSize, [&]
+    {
+        for (int lane = 0; lane < input.getNumChannels(); ++lane)
+            models[(size_t) lane].processBlock(input.getReadPointer(lane), output.getWritePointer(lane), c.blockSize);
+    });
+}
+
+double benchmarkModelBank(const Options& options, const Case& c)
+{
+    juce::AudioBuffer<float> input(c.numChannels * 2, c.blockSize);
+    juce::AudioBuffer<float> work(c.numChannels * 2, c.blockSize);
+    fillTestSignal(input, c.sampleRate);
+
+    PreisachModelBank<float> bank;
+    bank.prepare(c.numChannels, 2, c.blockSize);
+    bank.setDensityParams(c.preset->hysteresis, c.preset->asymmetry);
+    bank.setHarmonics(c.preset->evenHarmonics, c.preset->oddHarmonics);
+    bank.setBandDrive(0, c.preset->drive * 1.5f);
+    bank.setBandDrive(1, c.preset->drive * 0.5f);
+
+    return measure(options, c.blockSize, [&]
+    {
+        work.makeCopyOf(input, true);
+        bank.process(work.getArrayOfWritePointers(), c.blockSize);
+    });
+}
+
+// The Preisach operator at its default resolution, on the same lanes as modelBank
+double benchmarkPreisach(const Options& options, const Case& c)
+{
+    juce::AudioBuffer<float> input(c.numChannels * 2, c.blockSize);
+    juce::AudioBuffer<float> work(c.numChannels * 2, c.blockSize);
+    fillTestSignal(input, c.sampleRate);
+
+    PreisachModelBank<float> bank;
+    bank.prepare(c.numChannels, 2, c.blockSize);
+    bank.setSampleRate(c.sampleRate);
+    bank.setHysteresisModel(PreisachModelBank<float>::HysteresisModel::preisach);
+    bank.setDensityParams(c.preset->hysteresis, c.preset->asymmetry);
+
+    EverettTable table;
+    table.build(EverettTable::kDefaultResolution, c.preset->hysteresis);
+    bank.setEverettTable(table);
+    bank.setHarmonics(c.preset->evenHarmonics, c.preset->oddHarmonics);
+    bank.setBandDrive(0, c.preset->drive * 1.5f);
+    bank.setBandDrive(1, c.preset->drive * 0.5f);
+
+    return measure(options, c.blockSize, [&]
+    {
+        work.makeCopyOf(input, true);
+        bank.process(work.getArrayOfWritePointers(), c.blockSize);
+    });
+}
+
+// The shaping stage alone, over the interleaved lanes of a two band bank.
+// A null table runs the active vector kernel.
+double benchmarkShaper(const Options& options, const Case& c, const ShaperTable* table,
+                       ShaperTable::Interpolation interpolation)
+{
+    const int numValues = c.numChannels * 2 * c.blockSize;
+    juce::AudioBuffer<float> input(1, numValues);
+    juce::AudioBuffer<float> work(1, numValues);
+    fillTestSignal(input, c.sampleRate);
+    input.applyGain(c.preset->drive);
+
+    return measure(options, c.blockSize, [&]
+    {
+        work.copyFrom(0, 0, input, 0, 0, numValues);
+
+        if (table != nullptr)
+            table->process(work.getWritePointer(0), numValues, interpolation);
+        else
+            ShaperKernels::shape(work.getWritePointer(0), numValues, c.preset->evenHarmonics,
+                                 c.preset->oddHarmonics, c.preset->asymmetry);
+    });
+}
+
+double benchmarkShaperExact(const Options& options, const Case& c)
+{
+    return benchmarkShaper(options, c, nullptr, ShaperTable::Interpolation::linear);
+}
+
+double benchmarkShaperLinear(const Options& options, const Case& c)
+{
+    ShaperTable table;
+    table.build(c.preset->evenHarmonics, c.preset->oddHarmonics, c.preset->asymmetry);
+    return benchmarkShaper(options, c, &table, ShaperTable::Interpolation::linear);
+}
+
+double benchmarkShaperCubic(const Options& options, const Case& c)
+{
+    ShaperTable table;
+    table.build(c.preset->evenHarmonics, c.preset->oddHarmonics, c.preset->asymmetry);
+    return benchmarkShaper(options, c, &table, ShaperTable::Interpolation::cubic);
+}
+
+double benchmarkCrossover(const Options& options, const Case& c, CrossoverLayout::Mode mode)
+{
+    juce::AudioBuffer<float> input(c.numChannels, c.blockSize);
+    juce::AudioBuffer<float> bands(c.numChannels * CrossoverLayout::kMaxBands, c.blockSize);
+    fillTestSignal(input, c.sampleRate);
+
+    // Worst case: every band active
+    CrossoverEngine<float> crossover;
+    crossover.prepare(c.sampleRate, c.numChannels, c.blockSize);
+    crossover.setMode(mode);
+    crossover.setNumBands(CrossoverLayout::kMaxBands);
+
+    return measure(options, c.blockSize, [&]
+    {
+        crossover.process(input.getArrayOfReadPointers(), bands.getArrayOfWritePointers(), c.blockSize);
+    });
+}
+
+double benchmarkCrossoverLinkwitzRiley(const Options& options, const Case& c)
+{
+    return benchmarkCrossover(options, c, CrossoverLayout::Mode::linkwitzRiley);
+}
+
+double benchmarkCrossoverLinearPhase(const Options& options, const Case& c)
+{
+    return benchmarkCrossover(options, c, CrossoverLayout::Mode::linearPhase);
+}
+
+// Stage timings of the last processBlock case, picked up by main()
+juce::var lastStageProfile;
+
+enum class BlockInput
+{
+    signal,     // the test signal
+    silence,    // digital silence, timed once the tail has rung out
+    sidechain   // the test signal, with an envelope-followed sidechain on the drive
+};
+
+// The whole plugin at float or double precision. On silence the silence detector
+// skips the signal path; the sidechain case shows what audio-rate drive
+// modulation adds on top of the plain test signal.
+template <typename SampleType>
+double benchmarkProcessBlockAtPrecision(const Options& options, const Case& c, BlockInput blockInput = BlockInput::signal)
+{
+    TransformerAudioProcessor processor;
+    const bool withSidechain = blockInput == BlockInput::sidechain;
+    const int numSidechainChannels = withSidechain ? 2 : 0;
+
+    auto layout = processor.getBusesLayout();
+    layout.inputBuses.getReference(0) = juce::AudioChannelSet::canonicalChannelSet(c.numChannels);
+    layout.outputBuses.getReference(0) = juce::AudioChannelSet::canonicalChannelSet(c.numChannels);
+
+    if (layout.inputBuses.size() > 1)
+        layout.inputBuses.getReference(1) = withSidechain ? juce::AudioChannelSet::stereo()
+                                                          : juce::AudioChannelSet::disabled();
+
+    if (! processor.setBusesLayout(layout))
+        return 0.0;
+
+    if (withSidechain)
+    {
+        setParameter(processor, "sidechainMode", 2.0f);
+        setParameter(processor, "sidechainDepth", -0.5f);
+    }
+
+    setParameter(processor, "drive", c.preset->drive);
+    setParameter(processor, "evenHarmonics", c.preset->evenHarmonics);
+    setParameter(processor, "oddHarmonics", c.preset->oddHarmonics);
+    setParameter(processor, "hysteresis", c.preset->hysteresis);
+    setParameter(processor, "asymmetry", c.preset->asymmetry);
+    setParameter(processor, "oversampling", (float) c.preset->oversampling);
+
+    processor.setProcessingPrecision(std::is_same<SampleType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                              : juce::AudioProcessor::singlePrecision);
+    processor.setRateAndBufferSizeDetails(c.sampleRate, c.blockSize);
+    processor.prepareToPlay(c.sampleRate, c.blockSize);
+
+    // The sidechain's channels follow the main ones and get the same signal
+    const int numBufferChannels = c.numChannels + numSidechainChannels;
+    juce::AudioBuffer<float> signal(numBufferChannels, c.blockSize);
+    juce::AudioBuffer<SampleType> input(numBufferChannels, c.blockSize);
+    juce::AudioBuffer<SampleType> buffer(numBufferChannels, c.blockSize);
+    juce::MidiBuffer midi;
+    input.clear();
+
+    if (blockInput != BlockInput::silence)
+    {
+        fillTestSignal(signal, c.sampleRate);
+        input.makeCopyOf(signal);
+    }
+    else
+    {
+        // Ring out the tail first, so only the idle path is timed
+        const int tailBlocks = (int) std::ceil(processor.getTailLengthSeconds() * c.sampleRate / c.blockSize) + 1;
+
+        for (int i = 0; i < tailBlocks; ++i)
+        {
+            buffer.makeCopyOf(input, true);
+            processor.processBlock(buffer, midi);
+        }
+    }
+
+    const double ns = measure(options, c.blockSize, [&]
+    {
+        buffer.makeCopyOf(input, true);
+        processor.processBlock(buffer, midi);
+    });
+
+    if (StageProfiler::isEnabled())
+        lastStageProfile = processor.getStageProfiler().toVar();
+
+    processor.releaseResources();
+    return ns;
+}
+
+double benchmarkProcessBlock(const Options& options, const Case& c)
+{
+    return benchmarkProcessBlockAtPrecision<float>(options, c);
+}
+
+double benchmarkProcessBlockDouble(const Options& options, const Case& c)
+{
+    return benchmarkProcessBlockAtPrecision<double>(options, c);
+}
+
+double benchmarkProcessBlockSilent(const Options& options, const Case& c)
+{
+    return benchmarkProcessBlockAtPrecision<float>(options, c, BlockInput::silence);
+}
+
+double benchmarkProcessBlockSidechain(const Options& options, const Case& c)
+{
+    return benchmarkProcessBlockAtPrecision<float>(options, c, BlockInput::sidechain);
+}
+
+//==============================================================================
+struct Benchmark
+{
+    const char* name;
+    double (*run)(const Options&, const Case&);
+    bool usesOversamplingPresets;
+};
+
+const Benchmark benchmarks[] =
+{
+    { "model.process",      benchmarkModelProcess,           false },
+    { "model.processBlock", benchmarkModelProcessBlock,      false },
+    { "modelBank",          benchmarkModelBank,              false },
+    { "preisach",           benchmarkPreisach,               false },
+    { "shaper.exact",       benchmarkShaperExact,            false },
+    { "shaper.linear",      benchmarkShaperLinear,           false },
+    { "shaper.cubic",       benchmarkShaperCubic,            false },
+    { "crossover.lr4",      benchmarkCrossoverLinkwitzRiley, false },
+    { "crossover.linear",   benchmarkCrossoverLinearPhase,   false },
+    { "processBlock",       benchmarkProcessBlock,           true },
+    { "processBlock.double", benchmarkProcessBlockDouble,    true },
+    { "processBlock.silent", benchmarkProcessBlockSilent,    true },
+    { "processBlock.sidechain", benchmarkProcessBlockSidechain, true },
+};
+
+// Maximum deviation of every available shaper kernel from the std::tanh reference
+juce::var checkKernels()
+{
+    std::vector<float> input;
+
+    for (int i = -40000; i <= 40000; ++i)
+        input.push_back((float) i * 2.5e-4f);
+
+    juce::Array<juce::var> kernels;
+
+    for (auto isa : { ShaperKernels::Isa::scalar, ShaperKernels::Isa::sse2, ShaperKernels::Isa::avx2,
+                      ShaperKernels::Isa::avx512, ShaperKernels::Isa::neon })
+    {
+        auto kernel = ShaperKernels::getKernel(isa);
+
+        if (kernel == nullptr)
+            continue;
+
+        auto reference = input;
+        auto result = input;
+        ShaperKernels::shapeReference(reference.data(), (int) reference.size(), 0.3f, 1.0f, 0.1f);
+        kernel(result.data(), (int) result.size(), 0.3f, 1.0f, 0.1f);
+
+        float maxError = 0.0f;
+
+        for (size_t i = 0; i < result.size(); ++i)
+            maxError = juce::jmax(maxError, std::abs(result[i] - reference[i]) / juce::jmax(1.0f, std::abs(reference[i])));
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("isa", ShaperKernels::getIsaName(isa));
+        entry->setProperty("maxError", maxError);
+        entry->setProperty("withinBound", maxError <= ShaperKernels::kFastTanhMaxError * 1.1f);
+        kernels.add(juce::var(entry));
+    }
+
+    return kernels;
+}
+
+juce::String formatTable(const std::vector<Result>& results)
+{
+    juce::String text;
+    text << juce::String("benchmark").paddedRight(' ', 24) << juce::String("preset").paddedRight(' ', 10)
+         << juce::String("rate").paddedLeft(' ', 8) << juce::String("block").paddedLeft(' ', 7)
+         << juce::String("ch").paddedLeft(' ', 4) << juce::String("ns/sample").paddedLeft(' ', 12)
+         << juce::String("ns/ch").paddedLeft(' ', 10)
+         << juce::String("Msamples/s").paddedLeft(' ', 12) << juce::String("inst/core").paddedLeft(' ', 11) << "\n";
+
+    for (auto& r : results)
+    {
+        text << r.benchmarkCase.benchmark.paddedRight(' ', 24)
+             << juce::String(r.benchmarkCase.preset->name).paddedRight(' ', 10)
+             << juce::String(r.benchmarkCase.sampleRate, 0).paddedLeft(' ', 8)
+             << juce::String(r.benchmarkCase.blockSize).paddedLeft(' ', 7)
+             << juce::String(r.benchmarkCase.numChannels).paddedLeft(' ', 4)
+             << juce::String(r.nsPerSample, 2).paddedLeft(' ', 12)
+             << juce::String(r.getNsPerChannel(), 2).paddedLeft(' ', 10)
+             << juce::String(r.getSamplesPerSecond() / 1.0e6, 2).paddedLeft(' ', 12)
+             << juce::String(r.getInstancesPerCore(), 1).paddedLeft(' ', 11) << "\n";
+    }
+
+    return text;
+}
+
+juce::String formatCsv(const std::vector<Result>& results)
+{
+    juce::String text = "benchmark,preset,sampleRate,blockSize,channels,nsPerSample,nsPerChannel,samplesPerSecond,instancesPerCore\n";
+
+    for (auto& r : results)
+        text << r.benchmarkCase.benchmark << "," << r.benchmarkCase.preset->name << ","
+             << r.benchmarkCase.sampleRate << "," << r.benchmarkCase.blockSize << ","
+             << r.benchmarkCase.numChannels << "," << r.nsPerSample << "," << r.getNsPerChannel() << ","
+             << r.getSamplesPerSecond() << "," << r.getInstancesPerCore() << "\n";
+
+    return text;
+}
+
+juce::String formatJson(const std::vector<Result>& results)
+{
+    auto* root = new juce::DynamicObject();
+    root->setProperty("version", TRANSFORMER_VERSION);
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("isa", ShaperKernels::getIsaName(ShaperKernels::getActiveIsa()));
+    root->setProperty("kernels", checkKernels());
+    root->setProperty("stageProfiling", StageProfiler::isEnabled());
+
+    juce::Array<juce::var> entries;
+
+    for (auto& r : results)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("benchmark", r.benchmarkCase.benchmark);
+        entry->setProperty("preset", r.benchmarkCase.preset->name);
+        entry->setProperty("sampleRate", r.benchmarkCase.sampleRate);
+        entry->setProperty("blockSize", r.benchmarkCase.blockSize);
+        entry->setProperty("channels", r.benchmarkCase.numChannels);
+        entry->setProperty("nsPerSample", r.nsPerSample);
+        entry->setProperty("nsPerChannel", r.getNsPerChannel());
+        entry->setProperty("samplesPerSecond", r.getSamplesPerSecond());
+        entry->setProperty("instancesPerCore", r.getInstancesPerCore());
+
+        if (! r.stages.isVoid())
+            entry->setProperty("stages", r.stages);
+        entries.add(juce::var(entry));
+    }
+
+    root->setProperty("results", entries);
+    return juce::JSON::toString(juce::var(root));
+}
+
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    Options options;
+    options.filter = args.getValueForOption("--filter");
+    options.quick = args.containsOption("--quick");
+
+    if (args.containsOption("--min-time"))
+        options.minTime = juce::jmax(0.001, args.getValueForOption("--min-time").getDoubleValue());
+
+    if (args.containsOption("--repetitions"))
+        options.repetitions = juce::jmax(1, args.getValueForOption("--repetitions").getIntValue());
+
+    const auto format = args.containsOption("--format") ? args.getValueForOption("--format") : juce::String("table");
+
+    // Pins the shaper kernel, so every instruction set's path can be measured
+    if (args.containsOption("--isa"))
+    {
+        const auto name = args.getValueForOption("--isa");
+        auto isa = ShaperKernels::Isa::scalar;
+
+        if (! ShaperKernels::findIsa(name.toRawUTF8(), isa) || ! ShaperKernels::forceIsa(isa))
+        {
+            std::cerr << "error: instruction set " << name << " is not available here" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    std::vector<double> sampleRates { 44100.0, 48000.0, 96000.0, 192000.0 };
+    // Mono, stereo, 5.1, 7.1.4 and the 16 channel maximum
+    std::vector<int> channelCounts { 1, 2, 6, 12, 16 };
+
+    if (options.quick)
+    {
+        blockSizes = { 32, 512 };
+        sampleRates = { 48000.0 };
+        channelCounts = { 2 };
+    }
+
+    // Allocations in processBlock are counted rather than asserted, and reported below
+    RealtimeAllocationGuard::setViolationHandler([](std::size_t) {});
+
+    std::vector<Result> results;
+    int numAllocations = 0;
+
+    for (auto& benchmark : benchmarks)
+    {
+        if (options.filter.isNotEmpty() && ! juce::String(benchmark.name).contains(options.filter))
+            continue;
+
+        for (auto& preset : presets)
+        {
+            // Oversampling presets only change the full processor
+            if (preset.oversampling != presets[0].oversampling && ! benchmark.usesOversamplingPresets)
+                continue;
+
+            for (auto sampleRate : sampleRates)
+                for (auto blockSize : blockSizes)
+                    for (auto numChannels : channelCounts)
+                    {
+                        Case c { benchmark.name, &preset, sampleRate, blockSize, numChannels };
+                        RealtimeAllocationGuard::resetViolationCount();
+                        const double ns = benchmark.run(options, c);
+
+                        const int count = RealtimeAllocationGuard::getViolationCount();
+
+                        if (count > 0)
+                        {
+                            std::cerr << std::endl << "error: " << c.benchmark << " (" << preset.name << ", " << sampleRate
+                                      << " Hz, block " << blockSize << ", " << numChannels << " channels) made "
+                                      << count << " heap allocations on the audio thread" << std::endl;
+                            numAllocations += count;
+                        }
+
+                        if (ns > 0.0)
+                            results.push_back({ c, ns, lastStageProfile });
+
+                        lastStageProfile = juce::var();
+
+                        std::cerr << "." << std::flush;
+                    }
+        }
+    }
+
+    std::cerr << std::endl;
+
+    juce::String text;
+
+    if (format == "json")
+        text = formatJson(results);
+    else if (format == "csv")
+        text = formatCsv(results);
+    else
+        text = formatTable(results);
+
+    if (args.containsOption("--output"))
+    {
+        const auto outputFile = args.getFileForOption("--output");
+
+        if (! outputFile.replaceWithText(text))
+        {
+            std::cerr << "error: cannot write " << outputFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << text << std::endl;
+    }
+
+    return numAllocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,776 @@
+#include "TransformerEngine.h"
+
+template <typename SampleType>
+TransformerEngine<SampleType>::TransformerEngine(MeteringSource& meteringSource)
+    : metering(meteringSource)
+{
+    // Initialize transformer models with default settings
+    for (auto& path : paths)
+    {
+        path.modelBank.setDensityParams(0.2f, 0.1f);
+        path.modelBank.setHarmonics(0.3f, 1.0f);
+    }
+}
+
+template <typename SampleType>
+void TransformerEngine<SampleType>::prepare(double sampleRate, int numChannels, int newMaxBlockSize,
+                                            const TransformerSettings& newSettings)
+{
+    settings = newSettings;
+
+    // All scratch storage is allocated here so process() never touches the heap
+    maxBlockSize = juce::jmax(1, newMaxBlockSize);
+    inputPointers.assign((size_t) numChannels, nullptr);
+    lanePointers.assign((size_t) (numChannels * kMaxBands), nullptr);
+    driveRamp.assign((size_t) maxBlockSize, SampleType(0));
+    oversampledDriveRamp.assign((size_t) (maxBlockSize << kMaxOversamplingOrder), SampleType(0));
+    outputGainRamp.assign((size_t) maxBlockSize, SampleType(0));
+    scopeInput.assign((size_t) maxBlockSize, SampleType(0));
+    fadeRamp.assign((size_t) maxBlockSize, SampleType(0));
+    outgoingMix.assign((size_t) maxBlockSize, SampleType(0));
+
+    // Drive and output gain ramp per sample, the shaping parameters per block
+    driveSmoother.reset(sampleRate, 0.02);
+    outputGainSmoother.reset(sampleRate, 0.02);
+    evenHarmonicsSmoother.reset(sampleRate, 0.05);
+    oddHarmonicsSmoother.reset(sampleRate, 0.05);
+    hysteresisSmoother.reset(sampleRate, 0.05);
+    asymmetrySmoother.reset(sampleRate, 0.05);
+
+    driveSmoother.setCurrentAndTargetValue(settings.drive);
+    outputGainSmoother.setCurrentAndTargetValue(settings.outputGain);
+    evenHarmonicsSmoother.setCurrentAndTargetValue(settings.evenHarmonics);
+    oddHarmonicsSmoother.setCurrentAndTargetValue(settings.oddHarmonics);
+    hysteresisSmoother.setCurrentAndTargetValue(settings.hysteresis);
+    asymmetrySmoother.setCurrentAndTargetValue(settings.asymmetry);
+    previousDrive = settings.drive;
+
+    driveModulator.prepare(sampleRate);
+    updateDriveModulator();
+
+    for (size_t band = 0; band < bandDriveSmoothers.size(); ++band)
+    {
+        bandDriveSmoothers[band].reset(sampleRate, 0.05);
+        bandDriveSmoothers[band].setCurrentAndTargetValue(settings.bandDrives[band]);
+    }
+
+    // Both signal paths are allocated in full, so a change can crossfade to the
+    // other one without touching the heap
+    for (auto& path : paths)
+    {
+        // Frequency-dependent transformer behaviour: the crossover splits the input
+        // into bands that saturate independently. It gets the band count and
+        // frequencies first, so prepare() builds its first linear phase filters for them.
+        for (size_t split = 0; split < settings.crossoverFrequencies.size(); ++split)
+            path.crossover.setCrossoverFrequency((int) split, settings.crossoverFrequencies[split]);
+
+        path.crossover.setNumBands(settings.numBands);
+        path.crossover.prepare(sampleRate, numChannels, maxBlockSize);
+        path.numBands = -1;
+
+        // One independent model per channel and band (also resets them). The bank
+        // runs after upsampling, so it needs room for the largest factor.
+        path.modelBank.prepare(numChannels, kMaxBands, maxBlockSize * (1 << kMaxOversamplingOrder));
+        path.modelBank.setSampleRate(sampleRate);
+
+        // Polyphase IIR half-band oversamplers for every factor, so switching between
+        // realtime and render quality never allocates
+        for (size_t i = 0; i < path.oversamplers.size(); ++i)
+        {
+            path.oversamplers[i] = std::make_unique<juce::dsp::Oversampling<SampleType>>(
+                (size_t) (numChannels * kMaxBands), i + 1,
+                juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR, true, true);
+            path.oversamplers[i]->initProcessing((size_t) maxBlockSize);
+        }
+
+        path.bandBuffer.setSize(numChannels * kMaxBands, maxBlockSize);
+    }
+
+    int maxOversamplingLatency = 0;
+
+    for (auto& oversampler : paths[0].oversamplers)
+        maxOversamplingLatency = juce::jmax(maxOversamplingLatency, juce::roundToInt(oversampler->getLatencyInSamples()));
+
+    scopeDelay.assign((size_t) maxOversamplingLatency, SampleType(0));
+    scopeDelayLength = 0;
+
+    currentPath = 0;
+    fading = false;
+    fadeLength = juce::jmax(1, juce::roundToInt(sampleRate * kCrossfadeSeconds));
+
+    silentSamples = 0;
+    idle = false;
+
+    for (auto& path : paths)
+        path.oversamplingOrder = -1;
+
+    updateCrossover();
+    updateSignalPath();
+}
+
+template <typename SampleType>
+void TransformerEngine<SampleType>::setProfiler(StageProfiler* newProfiler)
+{
+    profiler = newProfiler;
+
+    for (auto& path : paths)
+        path.modelBank.setProfiler(newProfiler);
+}
+
+template <typename SampleType>
+void TransformerEngine<SampleType>::release()
+{
+    maxBlockSize = 0;
+    fading = false;
+
+    for (auto& path : paths)
+    {
+        path.bandBuffer.setSize(0, 0);
+
+        for (auto& oversampler : path.oversamplers)
+            oversampler.reset();
+    }
+}
+
+template <typename SampleType>
+void TransformerEngine<SampleType>::update(const TransformerSettings& newSettings)
+{
+    settings = newSettings;
+
+    // The smoothers ramp towards the new values over the coming samples
+    driveSmoother.setTargetValue(settings.drive);
+    outputGainSmoother.setTargetValue(settings.outputGain);
+    evenHarmonicsSmoother.setTargetValue(settings.evenHarmonics);
+    oddHarmonicsSmoother.setTargetValue(settings.oddHarmonics);
+    hysteresisSmoother.setTargetValue(settings.hysteresis);
+    asymmetrySmoother.setTargetValue(settings.asymmetry);
+
+    for (size_t band = 0; band < bandDriveSmoothers.size(); ++band)
+        bandDriveSmoothers[band].setTargetValue(settings.bandDrives[band]);
+
+    updateDriveModulator();
+
+    // Pick up crossover changes (including realtime/offline switches), then band
+    // count, hysteresis model and oversampling changes
+    updateCrossover();
+    updateSignalPath();
+}
+
+template <typename SampleType>
+juce::dsp::Oversampling<SampleType>* TransformerEngine<SampleType>::getActiveOversampler(const SignalPath& path) const
+{
+    if (path.oversamplingOrder <= 0)
+        return nullptr;
+
+    return path.oversamplers[(size_t) (path.oversamplingOrder - 1)].get();
+}
+
+template <typename SampleType>
+int TransformerEngine<SampleType>::getOversamplingLatency() const
+{
+    auto* oversampler = getActiveOversampler(getCurrentPath());
+    return oversampler != nullptr ? juce::roundToInt(oversampler->getLatencyInSamples()) : 0;
+}
+
+template <typename SampleType>
+void TransformerEngine<SampleType>::updateCrossover()
+{
+    // Linear phase waits for filters at the new band count, running the current
+    // mode until the builder has them
+    const int targetBands = juce::jlimit(CrossoverLayout::kMinBands, kMaxBands, settings.numBands);
+    const bool filtersReady = settings.crossoverMode != CrossoverLayout::Mode::linearPhase
+                           || getCurrentPath().crossover.hasLinearPhaseDesign(targetBands);
+
+    // The outgoing path keeps following the frequencies while it fades out
+    for (auto& path : paths)
+    {
+        // Offline renders build linear phase filters in place, so the output never
+        // depends on thread timing; realtime playback takes them from the builder
+        if (settings.nonRealtime)
+            path.crossover.setDesignInPlace();
+        else
+            path.crossover.setDesign(settings.crossoverDesign);
+
+        for (size_t split = 0; split < settings.crossoverFrequencies.size(); ++split)
+            path.crossover.setCrossoverFrequency((int) split, settings.crossoverFrequencies[split]);
+
+        if (filtersReady)
+            path.crossover.setMode(settings.crossoverMode);
+    }
+}
+
+template <typename SampleType>
+void TransformerEngine<SampleType>::updateSignalPath()
+{
+    const int targetBands = juce::jlimit(CrossoverLayout::kMinBands, kMaxBands, settings.numBands);
+    const auto model = settings.preisach ? HysteresisModel::preisach : HysteresisModel::decay;
+    const bool preisach = model == HysteresisModel::preisach;
+    const int order = juce::jlimit(0, kMaxOversamplingOrder, settings.oversamplingOrder);
+    auto& current = getCurrentPath();
+
+    // The resolution only matters while the Preisach operator runs
+    if (targetBands == current.numBands && model == current.modelBank.getHysteresisModel()
+        && order == current.oversamplingOrder
+        && (! preisach || settings.preisachResolution == current.modelBank.getPreisachResolution()))
+        return;
+
+    // Linear phase runs the current bands until there are filters for the new
+    // count, and one change at a time crossfades: the next waits for this one
+    if ((current.crossover.getMode() == CrossoverLayout::Mode::linearPhase
+         && ! current.crossover.hasLinearPhaseDesign(targetBands))
+        || fading)
+        return;
+
+    // The Preisach operator needs a table at the new resolution. prepare() and
+    // offline renders build it in place; realtime playback waits for the builder.
+    const EverettTable* table = nullptr;
+
+    if (preisach)
+    {
+        table = getEverettTable(settings.nonRealtime || current.numBands < 0);
+
+        if (table == nullptr || table->getResolution() != settings.preisachResolution)
+            return;
+    }
+
+    // Nothing is sounding after prepare() or while idle, so the current path
+    // restarts in place
+    if (current.numBands < 0 || idle)
+    {
+        configurePath(current, targetBands, model, table, order);
+        return;
+    }
+
+    // The other path takes over from the current crossover state, with empty
+    // model state, and fades in once its oversampling filters have filled
+    auto& incoming = getOutgoingPath();
+    configurePath(incoming, targetBands, model, table, order);
+    incoming.crossover.copyStateFrom(current.crossover);
+
+    currentPath = 1 - currentPath;
+    fading = true;
+    fadePosition = -2 * getOversamplingLatency();
+}
+
+template <typename SampleType>
+void TransformerEngine<SampleType>::configurePath(SignalPath& path, int bands, HysteresisModel model,
+                                                  const EverettTable* table, int order)
+{
+    // A new band count changes which lanes exist, so every stage starts over
+    path.numBands = bands;
+    path.crossover.setNumBands(bands);
+
+    // The history runs at the oversampled rate, so a new factor restarts it too
+    path.oversamplingOrder = order;
+
+    // All three reset the bank when they change it. A path taking over with the
+    // same settings, or only a new Preisach resolution, still holds the state of
+    // its last run.
+    auto& bank = path.modelBank;
+    const bool unchanged = bank.getNumBands() == bands && bank.getHysteresisModel() == model
+                        && bank.getOversamplingFactor() == 1 << order;
+
+    bank.setDensityParams((float) hysteresisSmoother.getCurrentValue(), (float) asymmetrySmoother.getCurrentValue());
+    bank.setNumActiveBands(bands);
+    bank.setHysteresisModel(model);
+    bank.setOversamplingFactor(1 << order);
+
+    if (table != nullptr)
+        bank.setEverettTable(*table);
+
+    if (unchanged)
+        bank.reset();
+
+    if (auto* oversampler = getActiveOversampler(path))
+        oversampler->reset();
+}
+
+template <typename SampleType>
+void TransformerEngine<SampleType>::updateDriveModulator()
+{
+    using Mode = typename DriveModulator<SampleType>::Mode;
+    driveModulator.setMode(settings.sidechainMode == 2 ? Mode::envelope
+                         : settings.sidechainMode == 1 ? Mode::direct : Mode::off);
+    driveModulator.setDepth(settings.sidechainDepth);
+    driveModulator.setAttackRelease(settings.sidechainAttack, settings.sidechainRelease);
+}
+
+// The Everett table for the current resolution and loop width, or nullptr
+template <typename SampleType>
+const EverettTable* TransformerEngine<SampleType>::getEverettTable(bool buildInPlace)
+{
+    if (! buildInPlace)
+        return settings.everettTable;
+
+    // Built from the smoothed width, so every offline run produces the same
+    // output regardless of thread timing
+    const float width = (float) hysteresisSmoother.getCurrentValue();
+
+    if (! offlineEverettTable.matches(settings.preisachResolution, width))
+        offlineEverettTable.build(settings.preisachResolution, width);
+
+    return &offlineEverettTable;
+}
+
+// Hands the running Preisach operators the table for the current loop width.
+// Only a table at a path's own resolution fits; a path fading out after a
+// resolution change keeps its last one.
+template <typename SampleType>
+void TransformerEngine<SampleType>::updateEverettTable()
+{
+    if (! settings.preisach)
+        return;
+
+    const EverettTable* table = getEverettTable(settings.nonRealtime);
+
+    if (table == nullptr)
+        return;
+
+    auto setTable = [table] (SignalPath& path)
+    {
+        if (path.modelBank.getHysteresisModel() == HysteresisModel::preisach
+            && path.modelBank.getPreisachResolution() == table->getResolution())
+            path.modelBank.setEverettTable(*table);
+    };
+
+    setTable(getCurrentPath());
+
+    if (fading)
+        setTable(getOutgoingPath());
+}
+
+template <typename SampleType>
+void TransformerEngine<SampleType>::updateShaperTable()
+{
+    const auto interpolation = settings.shaperMode == 2 ? ShaperTable::Interpolation::cubic
+                                                        : ShaperTable::Interpolation::linear;
+
+    // nullptr shapes with the exact curve
+    const ShaperTable* table = nullptr;
+
+    if (settings.shaperMode != 0 && settings.nonRealtime)
+    {
+        // Offline renders build in place from the smoothed values, so every run
+        // produces the same output regardless of thread timing
+        const float evenHarmonics = (float) evenHarmonicsSmoother.getCurrentValue();
+        const float oddHarmonics = (float) oddHarmonicsSmoother.getCurrentValue();
+        const float skew = (float) asymmetrySmoother.getCurrentValue();
+
+        if (! offlineShaperTable.matches(evenHarmonics, oddHarmonics, skew))
+            offlineShaperTable.build(evenHarmonics, oddHarmonics, skew);
+
+        table = &offlineShaperTable;
+    }
+    else if (settings.shaperMode != 0)
+    {
+        // Exact shaping until the first table arrives
+        table = settings.shaperTable;
+    }
+
+    getCurrentPath().modelBank.setShaperTable(table, interpolation);
+
+    if (fading)
+        getOutgoingPath().modelBank.setShaperTable(table, interpolation);
+}
+
+template <typename SampleType>
+int TransformerEngine<SampleType>::getLatencySamples() const
+{
+    return getCurrentPath().crossover.getLatencySamples() + getOversamplingLatency();
+}
+
+template <typename SampleType>
+int TransformerEngine<SampleType>::getTailSamples() const
+{
+    // The oversampling filters ring for about as long again as their delay
+    const auto& current = getCurrentPath();
+    return current.crossover.getTailSamples() + current.modelBank.getTailSamples() + 2 * getOversamplingLatency();
+}
+
+template <typename SampleType>
+void TransformerEngine<SampleType>::process(juce::AudioBuffer<SampleType>& buffer, int numChannels,
+                                            const juce::AudioBuffer<SampleType>* sidechain)
+{
+    // Scratch buffers are sized in prepare()
+    jassert(maxBlockSize > 0);
+
+    if (maxBlockSize <= 0)
+        return;
+
+    TRANSFORMER_PROFILE_STAGE(profiler, block);
+
+    // Hosts may send more samples than promised in prepareToPlay, so work in
+    // chunks that fit the preallocated band buffers
+    const int numSamples = buffer.getNumSamples();
+    const int numModelChannels = juce::jmin(buffer.getNumChannels(), getCurrentPath().modelBank.getNumChannels());
+
+    for (int startSample = 0; startSample < numSamples; startSample += maxBlockSize)
+    {
+        const int chunkSize = juce::jmin(maxBlockSize, numSamples - startSample);
+
+        if (! isSilent(buffer, numModelChannels, startSample, chunkSize))
+        {
+            silentSamples = 0;
+            idle = false;
+        }
+        else if (! idle)
+        {
+            silentSamples = juce::jmin(silentSamples + chunkSize, getTailSamples());
+        }
+
+        if (idle)
+        {
+            bypassChunk(buffer, numChannels, sidechain, startSample, chunkSize);
+            continue;
+        }
+
+        processChunk(buffer, numChannels, sidechain, startSample, chunkSize);
+
+        // Everything fed by the silent input has rung out, including this chunk's output
+        if (silentSamples >= getTailSamples()
+            && isSilent(buffer, juce::jmin(numChannels, numModelChannels), startSample, chunkSize)
+            && hasDecayed())
+            idle = true;
+    }
+}
+
+template <typename SampleType>
+bool TransformerEngine<SampleType>::isSilent(const juce::AudioBuffer<SampleType>& buffer, int numChannels,
+                                             int startSample, int numSamples) const
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+        if (buffer.getMagnitude(channel, startSample, numSamples) >= kSilenceThreshold)
+            return false;
+
+    return true;
+}
+
+// Judged against what sub-threshold input leaves behind: biquad states carry up
+// to a few times the signal, and the hysteresis state holds it after the drive.
+// A crossfade always finishes first, so only the current path is left.
+template <typename SampleType>
+bool TransformerEngine<SampleType>::hasDecayed() const
+{
+    if (fading)
+        return false;
+
+    const auto& current = getCurrentPath();
+    SampleType bandDrive = 1;
+
+    for (int band = 0; band < current.numBands; ++band)
+        bandDrive = juce::jmax(bandDrive, bandDriveSmoothers[(size_t) band].getCurrentValue());
+
+    const SampleType drive = juce::jmax(SampleType(1), driveSmoother.getCurrentValue() * bandDrive);
+
+    return current.crossover.getStateMagnitude() < 4 * kSilenceThreshold
+        && current.modelBank.getStateMagnitude() < drive * kSilenceThreshold;
+}
+
+// The output is silence; only the smoothers move on, so processing resumes at
+// the current parameter values
+template <typename SampleType>
+void TransformerEngine<SampleType>::bypassChunk(juce::AudioBuffer<SampleType>& buffer, int numInputChannels,
+                                                const juce::AudioBuffer<SampleType>* sidechain,
+                                                int startSample, int numSamples)
+{
+    driveSmoother.skip(numSamples);
+    outputGainSmoother.skip(numSamples);
+    evenHarmonicsSmoother.skip(numSamples);
+    oddHarmonicsSmoother.skip(numSamples);
+    hysteresisSmoother.skip(numSamples);
+    asymmetrySmoother.skip(numSamples);
+    previousDrive = driveSmoother.getCurrentValue();
+
+    for (auto& smoother : bandDriveSmoothers)
+        smoother.skip(numSamples);
+
+    // The envelope keeps following the sidechain
+    if (sidechain != nullptr)
+        driveModulator.skip(*sidechain, startSample, numSamples);
+
+    const auto& current = getCurrentPath();
+
+    for (int channel = 0; channel < juce::jmin(numInputChannels, current.modelBank.getNumChannels()); ++channel)
+        buffer.clear(channel, startSample, numSamples);
+
+    // Let the meters fall back
+    if (metering.isActive())
+    {
+        MeteringSource::LevelFrame levels;
+        levels.numBands = current.numBands;
+        metering.pushLevels(levels);
+    }
+}
+
+// Writes the smoother's next numSamples values, or a constant when it has settled
+template <typename SmoothedValueType, typename SampleType>
+static void fillRamp(SmoothedValueType& smoother, SampleType* dest, int numSamples)
+{
+    if (! smoother.isSmoothing())
+    {
+        juce::FloatVectorOperations::fill(dest, smoother.getCurrentValue(), numSamples);
+        return;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+        dest[i] = smoother.getNextValue();
+}
+
+// Peak and RMS across the channels of one band
+template <typename SampleType>
+static void measureBand(const juce::AudioBuffer<SampleType>& bands, int band, int numChannels, int numSamples,
+                        float& peak, float& rms)
+{
+    float sumOfSquares = 0.0f;
+    peak = 0.0f;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const int lane = band * numChannels + channel;
+        const float channelRms = (float) bands.getRMSLevel(lane, 0, numSamples);
+        peak = juce::jmax(peak, (float) bands.getMagnitude(lane, 0, numSamples));
+        sumOfSquares += channelRms * channelRms;
+    }
+
+    rms = numChannels > 0 ? std::sqrt(sumOfSquares / (float) numChannels) : 0.0f;
+}
+
+// Sum of one channel's bands
+template <typename SampleType>
+static void mixBands(const juce::AudioBuffer<SampleType>& bands, int numBands, int numChannels, int channel,
+                     SampleType* dest, int numSamples)
+{
+    juce::FloatVectorOperations::copy(dest, bands.getReadPointer(channel), numSamples);
+
+    for (int band = 1; band < numBands; ++band)
+        juce::FloatVectorOperations::add(dest, bands.getReadPointer(band * numChannels + channel), numSamples);
+}
+
+template <typename SampleType>
+void TransformerEngine<SampleType>::processChunk(juce::AudioBuffer<SampleType>& buffer, int numInputChannels,
+                                                 const juce::AudioBuffer<SampleType>* sidechain,
+                                                 int startSample, int numSamples)
+{
+    auto& current = getCurrentPath();
+    auto& outgoing = getOutgoingPath();
+    const int numChannels = current.modelBank.getNumChannels();
+    jassert(buffer.getNumChannels() >= numChannels);
+
+    // Metering costs two passes over the bands and a decimated scope copy, and
+    // nothing at all while the editor is closed
+    const bool metered = metering.isActive() && numChannels > 0;
+    MeteringSource::LevelFrame levels;
+
+    // Drive and output gain are read by the kernels as per-sample ramps
+    fillRamp(driveSmoother, driveRamp.data(), numSamples);
+    fillRamp(outputGainSmoother, outputGainRamp.data(), numSamples);
+
+    // Sidechain modulation lands in the same ramp, so the bank's inner loop (and
+    // the oversampled interpolation) cost the same with it on or off. With no
+    // depth the envelope still follows, ready for when the depth comes up.
+    if (sidechain != nullptr)
+    {
+        if (driveModulator.isActive())
+            driveModulator.process(*sidechain, startSample, driveRamp.data(), numSamples);
+        else
+            driveModulator.skip(*sidechain, startSample, numSamples);
+    }
+
+    // The shaping parameters step once per chunk; the bank only rebuilds its
+    // decay weights when the hysteresis value actually moves, and the Preisach
+    // operator takes prebuilt tables for it. Every band's drive
+    // moves on, so bands a change brings in start at their current value.
+    const float hysteresis = (float) hysteresisSmoother.skip(numSamples);
+    const float asymmetry = (float) asymmetrySmoother.skip(numSamples);
+    const float evenHarmonics = (float) evenHarmonicsSmoother.skip(numSamples);
+    const float oddHarmonics = (float) oddHarmonicsSmoother.skip(numSamples);
+    std::array<float, kMaxBands> bandDrives;
+
+    for (size_t band = 0; band < bandDriveSmoothers.size(); ++band)
+        bandDrives[band] = (float) bandDriveSmoothers[band].skip(numSamples);
+
+    auto setModelParameters = [&] (SignalPath& path)
+    {
+        path.modelBank.setDensityParams(hysteresis, asymmetry);
+        path.modelBank.setHarmonics(evenHarmonics, oddHarmonics);
+
+        // Per-band drive scaling; the overall drive arrives per sample through the ramp
+        for (int band = 0; band < path.numBands; ++band)
+            path.modelBank.setBandDrive(band, bandDrives[(size_t) band]);
+    };
+
+    setModelParameters(current);
+
+    if (fading)
+        setModelParameters(outgoing);
+
+    updateEverettTable();
+    updateShaperTable();
+
+    // Split every channel into bands in one pass; band b of channel c lands in
+    // channel b * numChannels + c
+    for (int channel = 0; channel < numChannels; ++channel)
+        inputPointers[(size_t) channel] = buffer.getReadPointer(channel, startSample);
+
+    {
+        TRANSFORMER_PROFILE_STAGE(profiler, split);
+        current.crossover.process(inputPointers.data(), current.bandBuffer.getArrayOfWritePointers(), numSamples);
+
+        // A path fading out at the same band count has the same crossover state
+        // (it handed it over), so it shares these bands instead of splitting again
+        if (fading && outgoing.numBands == current.numBands)
+        {
+            for (int lane = 0; lane < numChannels * current.numBands; ++lane)
+                outgoing.bandBuffer.copyFrom(lane, 0, current.bandBuffer, lane, 0, numSamples);
+        }
+        else if (fading)
+        {
+            outgoing.crossover.process(inputPointers.data(), outgoing.bandBuffer.getArrayOfWritePointers(), numSamples);
+        }
+    }
+
+    if (metered)
+    {
+        levels.numBands = current.numBands;
+
+        // The scope plots what the bank does, so X is channel 0's bands summed
+        // before it, with the crossover's delay already in them
+        mixBands(current.bandBuffer, current.numBands, numChannels, 0, scopeInput.data(), numSamples);
+        delayScopeInput(numSamples);
+
+        for (int band = 0; band < current.numBands; ++band)
+            measureBand(current.bandBuffer, band, numChannels, numSamples,
+                        levels.inputPeak[(size_t) band], levels.inputRms[(size_t) band]);
+    }
+
+    processModelBank(current, numSamples);
+
+    if (fading)
+        processModelBank(outgoing, numSamples);
+
+    previousDrive = driveRamp[(size_t) (numSamples - 1)];
+
+    if (metered)
+    {
+        for (int band = 0; band < current.numBands; ++band)
+            measureBand(current.bandBuffer, band, numChannels, numSamples,
+                        levels.outputPeak[(size_t) band], levels.outputRms[(size_t) band]);
+
+        metering.pushLevels(levels);
+    }
+
+    // Mix back together, crossfade from the outgoing path and apply output gain
+    TRANSFORMER_PROFILE_STAGE(profiler, mix);
+
+    if (fading)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            fadeRamp[(size_t) i] = (SampleType) juce::jlimit(0, fadeLength, fadePosition + i + 1) / (SampleType) fadeLength;
+    }
+
+    for (int channel = 0; channel < juce::jmin(numInputChannels, numChannels); ++channel)
+    {
+        SampleType* originalData = buffer.getWritePointer(channel, startSample);
+
+        mixBands(current.bandBuffer, current.numBands, numChannels, channel, originalData, numSamples);
+
+        // outgoing + (current - outgoing) * fade
+        if (fading)
+        {
+            mixBands(outgoing.bandBuffer, outgoing.numBands, numChannels, channel, outgoingMix.data(), numSamples);
+            juce::FloatVectorOperations::subtract(originalData, outgoingMix.data(), numSamples);
+            juce::FloatVectorOperations::multiply(originalData, fadeRamp.data(), numSamples);
+            juce::FloatVectorOperations::add(originalData, outgoingMix.data(), numSamples);
+        }
+
+        // The scope shows the transfer curve, so it takes the output before the gain
+        if (metered && channel == 0)
+            metering.pushScope(scopeInput.data(), originalData, numSamples);
+
+        juce::FloatVectorOperations::multiply(originalData, outputGainRamp.data(), numSamples);
+    }
+
+    if (fading)
+    {
+        fadePosition += numSamples;
+        fading = fadePosition < fadeLength;
+    }
+}
+
+// Delays scopeInput by the oversampling latency, which only the output on the
+// scope's Y axis goes through
+template <typename SampleType>
+void TransformerEngine<SampleType>::delayScopeInput(int numSamples)
+{
+    const int latency = juce::jmin(getOversamplingLatency(), (int) scopeDelay.size());
+
+    if (latency != scopeDelayLength)
+    {
+        std::fill(scopeDelay.begin(), scopeDelay.end(), SampleType(0));
+        scopeDelayLength = latency;
+        scopeDelayPosition = 0;
+    }
+
+    if (scopeDelayLength == 0)
+        return;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        std::swap(scopeInput[(size_t) i], scopeDelay[(size_t) scopeDelayPosition]);
+        scopeDelayPosition = scopeDelayPosition + 1 < scopeDelayLength ? scopeDelayPosition + 1 : 0;
+    }
+}
+
+// Applies the Preisach transformer model to every channel and band of the path
+// in one pass, at the oversampled rate when oversampling is active
+template <typename SampleType>
+void TransformerEngine<SampleType>::processModelBank(SignalPath& path, int numSamples)
+{
+    const int numLanes = path.modelBank.getNumChannels() * path.numBands;
+
+    juce::dsp::AudioBlock<SampleType> bandBlock(path.bandBuffer);
+    auto bandChunk = bandBlock.getSubsetChannelBlock(0, (size_t) numLanes)
+                              .getSubBlock(0, (size_t) numSamples);
+
+    if (auto* oversampler = getActiveOversampler(path))
+    {
+        // Interpolate the drive ramp up to the path's rate. Only the paths either
+        // side of an oversampling change differ, so both interpolate from the
+        // previous chunk's last drive.
+        const int factor = 1 << path.oversamplingOrder;
+        SampleType* ramp = oversampledDriveRamp.data();
+        SampleType drive = previousDrive;
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            const SampleType step = (driveRamp[(size_t) sample] - drive) / (SampleType) factor;
+
+            for (int i = 0; i < factor; ++i)
+                *ramp++ = drive + step * (SampleType) (i + 1);
+
+            drive = driveRamp[(size_t) sample];
+        }
+
+        juce::dsp::AudioBlock<SampleType> upsampled;
+
+        {
+            TRANSFORMER_PROFILE_STAGE(profiler, upsample);
+            upsampled = oversampler->processSamplesUp(bandChunk);
+        }
+
+        for (size_t lane = 0; lane < upsampled.getNumChannels(); ++lane)
+            lanePointers[lane] = upsampled.getChannelPointer(lane);
+
+        path.modelBank.process(lanePointers.data(), (int) upsampled.getNumSamples(), oversampledDriveRamp.data());
+
+        TRANSFORMER_PROFILE_STAGE(profiler, downsample);
+        oversampler->processSamplesDown(bandChunk);
+    }
+    else
+    {
+        path.modelBank.process(path.bandBuffer.getArrayOfWritePointers(), numSamples, driveRamp.data());
+    }
+}
+
+template class TransformerEngine<float>;
+template class TransformerEngine<double>;
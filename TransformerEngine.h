@@ -0,0 +1,212 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include "PreisachModelBank.h"
+#include "CrossoverEngine.h"
+#include "ShaperTable.h"
+#include "EverettTable.h"
+#include "DriveModulator.h"
+#include "StageProfiler.h"
+#include "Metering.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+// Parameter values for one block, read from the processor's parameters
+struct TransformerSettings
+{
+    float drive = 1.0f;
+    float outputGain = 1.0f;
+    float evenHarmonics = 0.3f;
+    float oddHarmonics = 1.0f;
+    float hysteresis = 0.2f;
+    float asymmetry = 0.1f;
+    std::array<float, CrossoverLayout::kMaxBands> bandDrives {};
+    std::array<float, CrossoverLayout::kMaxSplits> crossoverFrequencies {};
+    int numBands = CrossoverLayout::kMinBands;
+    CrossoverLayout::Mode crossoverMode = CrossoverLayout::Mode::linkwitzRiley;
+    const LinearPhaseDesign* crossoverDesign = nullptr; // latest background-built linear phase filters (realtime)
+    int oversamplingOrder = 0;
+    bool preisach = false;
+    int preisachResolution = 64;
+    const EverettTable* everettTable = nullptr; // latest background-built Preisach table (realtime)
+    int shaperMode = 0;                         // 0 exact, 1 linear table, 2 cubic table
+    const ShaperTable* shaperTable = nullptr;   // latest background-built table (realtime)
+    int sidechainMode = 0;                      // 0 off, 1 direct, 2 envelope follower
+    float sidechainDepth = 0.0f;
+    float sidechainAttack = 5.0f;               // ms
+    float sidechainRelease = 100.0f;            // ms
+    bool nonRealtime = false;
+};
+
+// The transformer's signal path: crossover, per-band model bank (oversampled when
+// requested), band mix and output gain, with the parameter smoothing that feeds it.
+// An optional sidechain modulates the drive at audio rate through the same
+// per-sample drive ramp the bank already reads.
+//
+// A band count, hysteresis model or Preisach resolution change restarts the
+// crossover layout and the model state. While sound is playing the engine keeps a second signal path for
+// that: the new configuration starts there from the crossover's current state,
+// and its output crossfades in over kCrossfadeSeconds while the old path fades
+// out. Snapshot morphs step these parameters mid-stream, so they must not click.
+//
+// Once the input has been silent for the whole tail and every stage has decayed
+// below kSilenceThreshold, the engine goes idle: it writes zeros and only advances
+// the smoothers until the input comes back. The skipped stages hold sub-threshold
+// state at that point, so processing resumes from them without a step.
+//
+// SampleType is float or double. Both are compiled from TransformerEngine.cpp and
+// share the same band and lane layout, so the double path only differs in element
+// width. The processor holds one of each and prepares the one the host asks for.
+template <typename SampleType>
+class TransformerEngine
+{
+public:
+    static constexpr int kMaxBands = CrossoverLayout::kMaxBands;
+
+    // Up to 8x oversampling around the saturation stage
+    static constexpr int kMaxOversamplingOrder = 3;
+
+    // -120 dBFS: input and state below this count as silence
+    static constexpr SampleType kSilenceThreshold = SampleType(1.0e-6);
+
+    // Length of the crossfade between signal paths after a band count,
+    // hysteresis model or Preisach resolution change
+    static constexpr double kCrossfadeSeconds = 0.02;
+
+    explicit TransformerEngine(MeteringSource& meteringSource);
+
+    // Allocates all storage for numChannels channels and blocks of up to
+    // maxBlockSize samples, starting settled at these settings
+    void prepare(double sampleRate, int numChannels, int maxBlockSize, const TransformerSettings& settings);
+    void release();
+    bool isPrepared() const { return maxBlockSize > 0; }
+
+    // Once per block before process(): new smoother targets, and band count,
+    // crossover, oversampling and hysteresis model changes
+    void update(const TransformerSettings& newSettings);
+
+    // Processes the first numChannels channels of buffer in place. Any block
+    // length works; longer blocks run in chunks of maxBlockSize. sidechain, when
+    // given, has the same length as buffer and drives the modulation.
+    void process(juce::AudioBuffer<SampleType>& buffer, int numChannels,
+                 const juce::AudioBuffer<SampleType>* sidechain = nullptr);
+
+    // Crossover plus oversampling filter delay for the current settings
+    int getLatencySamples() const;
+
+    // Samples until the output has decayed by 120 dB after the input stops
+    int getTailSamples() const;
+
+    // True while processing is skipped for silence
+    bool isIdle() const { return idle; }
+
+    // Loop width the hysteresis is currently smoothing through. Realtime playback
+    // requests its Everett tables for this, so a moving width is followed one
+    // background-built table at a time.
+    float getHysteresisWidth() const { return (float) hysteresisSmoother.getCurrentValue(); }
+
+    // Receives per-stage timings in builds with TRANSFORMER_PROFILE_STAGES
+    void setProfiler(StageProfiler* newProfiler);
+
+private:
+    using HysteresisModel = typename PreisachModelBank<SampleType>::HysteresisModel;
+
+    // Everything a band count, hysteresis model, resolution or oversampling
+    // change restarts
+    struct SignalPath
+    {
+        // Splits the input into numBands bands ahead of the model bank
+        CrossoverEngine<SampleType> crossover;
+        int numBands = -1;  // -1 until configured after prepare()
+
+        // Independent model state for every channel and band
+        PreisachModelBank<SampleType> modelBank;
+
+        // One oversampler per factor (2x, 4x, 8x), built in prepare()
+        std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, kMaxOversamplingOrder> oversamplers;
+        int oversamplingOrder = -1;  // index + 1 of the one in use, 0 for none
+
+        // Band scratch buffer (kMaxBands * channels), sized in prepare()
+        juce::AudioBuffer<SampleType> bandBuffer;
+    };
+
+    SignalPath& getCurrentPath() { return paths[(size_t) currentPath]; }
+    const SignalPath& getCurrentPath() const { return paths[(size_t) currentPath]; }
+    SignalPath& getOutgoingPath() { return paths[(size_t) (1 - currentPath)]; }
+
+    void processChunk(juce::AudioBuffer<SampleType>& buffer, int numInputChannels,
+                      const juce::AudioBuffer<SampleType>* sidechain, int startSample, int numSamples);
+    void bypassChunk(juce::AudioBuffer<SampleType>& buffer, int numInputChannels,
+                     const juce::AudioBuffer<SampleType>* sidechain, int startSample, int numSamples);
+    bool isSilent(const juce::AudioBuffer<SampleType>& buffer, int numChannels, int startSample, int numSamples) const;
+    bool hasDecayed() const;
+    void processModelBank(SignalPath& path, int numSamples);
+
+    juce::dsp::Oversampling<SampleType>* getActiveOversampler(const SignalPath& path) const;
+    int getOversamplingLatency() const;
+    void updateCrossover();
+    void updateSignalPath();
+    void configurePath(SignalPath& path, int bands, HysteresisModel model, const EverettTable* table, int order);
+    const EverettTable* getEverettTable(bool buildInPlace);
+    void updateEverettTable();
+    void updateShaperTable();
+    void updateDriveModulator();
+    void delayScopeInput(int numSamples);
+
+    MeteringSource& metering;
+    StageProfiler* profiler = nullptr;
+    TransformerSettings settings;
+
+    // Parameter smoothing to avoid zipper noise under fast automation
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Multiplicative> driveSmoother;
+    juce::SmoothedValue<SampleType> outputGainSmoother;
+    juce::SmoothedValue<SampleType> evenHarmonicsSmoother;
+    juce::SmoothedValue<SampleType> oddHarmonicsSmoother;
+    juce::SmoothedValue<SampleType> hysteresisSmoother;
+    juce::SmoothedValue<SampleType> asymmetrySmoother;
+    std::array<juce::SmoothedValue<SampleType>, kMaxBands> bandDriveSmoothers;
+
+    // Per-sample ramps, sized in prepare()
+    std::vector<SampleType> driveRamp;
+    std::vector<SampleType> oversampledDriveRamp;
+    std::vector<SampleType> outputGainRamp;
+    SampleType previousDrive = 1;
+
+    // Scales the drive ramp from the sidechain
+    DriveModulator<SampleType> driveModulator;
+
+    // The current signal path, and the other one: idle, or fading out after a change
+    std::array<SignalPath, 2> paths;
+    int currentPath = 0;
+
+    // Crossfade from the outgoing path: samples into the fade, negative while
+    // the current path's oversampling filters fill after the change
+    bool fading = false;
+    int fadePosition = 0;
+    int fadeLength = 1;
+    std::vector<SampleType> fadeRamp;
+    std::vector<SampleType> outgoingMix;
+
+    // Offline renders build their shaper and Everett tables in place, and so
+    // does prepare() for the first Everett table
+    ShaperTable offlineShaperTable;
+    EverettTable offlineEverettTable;
+
+    // The scope's X axis: the bank's input for channel 0, delayed by the
+    // oversampling filters so it lines up with the output on Y
+    std::vector<SampleType> scopeInput;
+    std::vector<SampleType> scopeDelay;     // longest oversampling latency, sized in prepare()
+    int scopeDelayLength = 0;
+    int scopeDelayPosition = 0;
+
+    std::vector<const SampleType*> inputPointers;
+    std::vector<SampleType*> lanePointers;
+    int maxBlockSize = 0;
+
+    // Silence detection: input samples below the threshold since the last
+    // sound, and whether the stages are currently skipped
+    int silentSamples = 0;
+    bool idle = false;
+
+    JUCE_DECLARE_NON_COPYABLE (TransformerEngine)
+};
@@ -0,0 +1,521 @@
+// Golden-reference regression check for the processor output.
+//
+//   TransformerRegression --golden-dir=<dir> [options]
+//
+//   --golden-dir=<dir>     Where the golden renders live (required)
+//   --generate             Write new golden files instead of comparing
+//   --filter=<text>        Only run cases whose name contains text
+//   --double               Render through the double precision path
+//   --isa=<name>           Shaper kernel to use: scalar, sse2, avx2, avx512 or neon
+//                          (default: the best one for this CPU)
+//   --null-db=<dB>         Largest residual peak against the golden render, in
+//                          dBFS (default: -80)
+//   --thd-db=<dB>          Largest THD change on the sine cases (default: 0.1)
+//   --alias-db=<dB>        Largest rise of the aliasing floor on the sine cases
+//                          (default: 1)
+//   --json=<file>          Also write every case's metrics as JSON
+//
+// Every case renders one test signal through a fresh TransformerAudioProcessor at
+// one sample rate, block size and parameter set, in offline mode so shaper tables
+// are built deterministically. Golden renders are 32-bit float WAVs named after
+// the case; the committed ones live in golden/ and CTest checks against them.
+//
+// A case passes when the null test against its golden render stays below
+// --null-db. The sine cases also compare THD and the aliasing floor (everything
+// that is neither DC nor a harmonic) of the output, so a faster kernel that nulls
+// within tolerance but changes the character of the distortion is still caught.
+// The default null threshold admits the fastTanh approximation error. In builds
+// with TRANSFORMER_CHECK_RT_ALLOCATIONS (Debug), a case also fails if its render
+// allocated on the audio thread. Exits with 1 if any case fails.
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "PluginProcessor.h"
+#include "RealtimeAllocationGuard.h"
+#include "ShaperKernels.h"
+#include <cmath>
+#include <functional>
+#include <type_traits>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+struct ParameterSet
+{
+    const char* name;
+    std::vector<std::pair<const char*, float>> values; // parameter ID, plain value (choice index for choices)
+};
+
+// The renders are offline, so every set pins the render quality to "Same as
+// Realtime"; otherwise its 8x default would replace the oversampling chosen here
+// and the Off, 2x and 4x paths would never run
+const ParameterSet parameterSets[] =
+{
+    { "default",   { { "renderQuality", 0.0f } } },
+    { "hot",       { { "drive", 6.0f }, { "evenHarmonics", 1.0f }, { "hysteresis", 0.05f },
+                     { "asymmetry", 0.3f }, { "oversampling", 0.0f }, { "renderQuality", 0.0f } } },
+    { "preisach",  { { "drive", 3.0f }, { "hysteresisModel", 1.0f }, { "preisachResolution", 1.0f },
+                     { "oversampling", 2.0f }, { "renderQuality", 0.0f } } },
+    { "multiband", { { "numBands", 3.0f }, { "crossoverMode", 1.0f }, { "shaper", 2.0f },
+                     { "bandDrive2", 2.0f }, { "oversampling", 1.0f }, { "renderQuality", 0.0f } } },
+};
+
+struct TestSignal
+{
+    const char* name;
+    double frequency; // sine frequency for the spectral metrics, 0 for none
+    std::function<double(int sample, int channel, double sampleRate)> generate;
+};
+
+constexpr double kSignalSeconds = 1.0;
+
+// White noise hashed from the sample position (splitmix64), so every run and
+// every block size sees the same signal
+double noiseSample(int sample, int channel)
+{
+    auto z = (juce::uint64) sample + ((juce::uint64) channel << 40) + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    return (double) (z >> 11) / (double) (1ull << 53) * 2.0 - 1.0;
+}
+
+// The sine frequencies are multiples of 2 Hz, so they fall exactly on a bin of
+// the half-second analysis window at every sample rate
+const TestSignal testSignals[] =
+{
+    { "sine1k", 1000.0, [](int n, int ch, double fs)
+      { return 0.5 * std::sin(juce::MathConstants<double>::twoPi * 1000.0 * n / fs + 0.25 * ch); } },
+
+    { "sine7k", 7000.0, [](int n, int ch, double fs)
+      { return 0.7 * std::sin(juce::MathConstants<double>::twoPi * 7000.0 * n / fs + 0.25 * ch); } },
+
+    { "sweep", 0.0, [](int n, int, double fs)
+      {
+          // Logarithmic 20 Hz to 20 kHz over the whole signal
+          const double t = n / fs, k = std::log(1000.0) / kSignalSeconds;
+          return 0.5 * std::sin(juce::MathConstants<double>::twoPi * 20.0 * (std::exp(k * t) - 1.0) / k);
+      } },
+
+    { "impulses", 0.0, [](int n, int, double fs)
+      { return n % (int) (fs / 4.0) == 0 ? 0.9 : 0.0; } },
+
+    { "noise", 0.0, [](int n, int ch, double)
+      { return 0.25 * noiseSample(n, ch); } },
+
+    { "transients", 0.0, [](int n, int ch, double fs)
+      {
+          // Decaying 200 Hz bursts with a hard onset every 200 ms
+          const double t = std::fmod(n / fs, 0.2);
+          return 0.8 * std::exp(-t * 40.0) * std::sin(juce::MathConstants<double>::twoPi * 200.0 * t)
+               + 0.1 * std::exp(-t * 400.0) * noiseSample(n, ch);
+      } },
+};
+
+const double sampleRates[] = { 44100.0, 96000.0 };
+const int blockSizes[] = { 64, 441 };
+constexpr int kNumChannels = 2;
+
+struct Options
+{
+    juce::File goldenDirectory;
+    juce::String filter;
+    bool generate = false;
+    bool doublePrecision = false;
+    double nullThresholdDb = -80.0;
+    double thdToleranceDb = 0.1;
+    double aliasToleranceDb = 1.0;
+};
+
+struct Case
+{
+    const ParameterSet* parameters;
+    const TestSignal* signal;
+    double sampleRate;
+    int blockSize;
+
+    juce::String getName() const
+    {
+        return juce::String(parameters->name) + "_" + signal->name + "_"
+             + juce::String((int) sampleRate) + "_" + juce::String(blockSize);
+    }
+};
+
+void setParameter(TransformerAudioProcessor& processor, const juce::String& id, float value)
+{
+    if (auto* parameter = processor.parameters.getParameter(id))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+// Renders the case's signal through a fresh processor, block by block
+template <typename SampleType>
+juce::AudioBuffer<float> render(const Case& c)
+{
+    TransformerAudioProcessor processor;
+
+    // Main buses only; the sidechain bus stays disabled
+    auto layout = processor.getBusesLayout();
+    layout.inputBuses.getReference(0) = juce::AudioChannelSet::stereo();
+    layout.outputBuses.getReference(0) = juce::AudioChannelSet::stereo();
+    processor.setBusesLayout(layout);
+
+    for (auto& value : c.parameters->values)
+        setParameter(processor, value.first, value.second);
+
+    processor.setNonRealtime(true);
+    processor.setProcessingPrecision(std::is_same<SampleType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                              : juce::AudioProcessor::singlePrecision);
+    processor.setRateAndBufferSizeDetails(c.sampleRate, c.blockSize);
+    processor.prepareToPlay(c.sampleRate, c.blockSize);
+
+    const int numSamples = (int) (kSignalSeconds * c.sampleRate);
+    juce::AudioBuffer<float> output(kNumChannels, numSamples);
+    juce::AudioBuffer<SampleType> block(kNumChannels, c.blockSize);
+    juce::MidiBuffer midi;
+
+    for (int start = 0; start < numSamples; start += c.blockSize)
+    {
+        const int count = juce::jmin(c.blockSize, numSamples - start);
+        block.setSize(kNumChannels, count, false, false, true);
+
+        for (int channel = 0; channel < kNumChannels; ++channel)
+            for (int i = 0; i < count; ++i)
+                block.setSample(channel, i, (SampleType) c.signal->generate(start + i, channel, c.sampleRate));
+
+        processor.processBlock(block, midi);
+
+        for (int channel = 0; channel < kNumChannels; ++channel)
+            for (int i = 0; i < count; ++i)
+                output.setSample(channel, start + i, (float) block.getSample(channel, i));
+    }
+
+    processor.releaseResources();
+    return output;
+}
+
+//==============================================================================
+bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate)
+{
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+
+    if (! stream->openedOk())
+        return false;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+                                                                        (unsigned int) buffer.getNumChannels(),
+                                                                        32, {}, 0));
+
+    if (writer == nullptr)
+        return false;
+
+    stream.release(); // now owned by the writer
+    return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
+
+bool readWav(const juce::File& file, juce::AudioBuffer<float>& buffer)
+{
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(file.createInputStream().release(), true));
+
+    if (reader == nullptr)
+        return false;
+
+    buffer.setSize((int) reader->numChannels, (int) reader->lengthInSamples);
+    return reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+}
+
+//==============================================================================
+double toDb(double ratio)
+{
+    return 10.0 * std::log10(juce::jmax(ratio, 1.0e-30));
+}
+
+// Energy of one bin of an n point DFT, scaled so tone energies add up to the
+// signal's sum of squares
+double toneEnergy(const float* x, int n, double frequency, double sampleRate)
+{
+    const double coefficient = 2.0 * std::cos(juce::MathConstants<double>::twoPi * frequency / sampleRate);
+    double s1 = 0.0, s2 = 0.0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        const double s0 = x[i] + coefficient * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+
+    const double power = s1 * s1 + s2 * s2 - coefficient * s1 * s2;
+    return 2.0 * power / n;
+}
+
+constexpr double kAliasFloorDb = -140.0;
+
+struct Spectrum
+{
+    double thdDb = 0.0;     // harmonics 2 and up against the fundamental
+    double aliasDb = 0.0;   // everything but DC and harmonics against the fundamental
+};
+
+// Measured over the second half of channel 0, after the start-up transients
+Spectrum analyse(const juce::AudioBuffer<float>& buffer, double frequency, double sampleRate)
+{
+    const int n = (int) (sampleRate * 0.5);
+    const float* x = buffer.getReadPointer(0, buffer.getNumSamples() - n);
+
+    double total = 0.0, sum = 0.0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        total += (double) x[i] * x[i];
+        sum += x[i];
+    }
+
+    const double dc = sum * sum / n;
+    const double fundamental = toneEnergy(x, n, frequency, sampleRate);
+    double harmonics = 0.0;
+
+    for (double harmonic = 2.0 * frequency; harmonic < 0.5 * sampleRate; harmonic += frequency)
+        harmonics += toneEnergy(x, n, harmonic, sampleRate);
+
+    Spectrum spectrum;
+    spectrum.thdDb = toDb(harmonics / fundamental);
+    // Clamped to the resolution of a float render, so rounding noise cannot fail a case
+    spectrum.aliasDb = juce::jmax(kAliasFloorDb, toDb(juce::jmax(0.0, total - dc - fundamental - harmonics) / fundamental));
+    return spectrum;
+}
+
+//==============================================================================
+struct Result
+{
+    juce::String name;
+    juce::String error;
+    double nullDb = 0.0;
+    bool hasSpectrum = false;
+    Spectrum spectrum, goldenSpectrum;
+    bool passed = false;
+};
+
+Result verify(const Options& options, const Case& c, const juce::AudioBuffer<float>& output, int numAllocations)
+{
+    Result result;
+    result.name = c.getName();
+
+    if (numAllocations > 0)
+    {
+        result.error = juce::String(numAllocations) + " heap allocations on the audio thread";
+        return result;
+    }
+
+    juce::AudioBuffer<float> golden;
+
+    if (! readWav(options.goldenDirectory.getChildFile(result.name + ".wav"), golden))
+    {
+        result.error = "missing golden render";
+        return result;
+    }
+
+    if (golden.getNumChannels() != output.getNumChannels() || golden.getNumSamples() != output.getNumSamples())
+    {
+        result.error = "golden render has a different length or channel count";
+        return result;
+    }
+
+    float residual = 0.0f;
+
+    for (int channel = 0; channel < output.getNumChannels(); ++channel)
+        for (int i = 0; i < output.getNumSamples(); ++i)
+            residual = juce::jmax(residual, std::abs(output.getSample(channel, i) - golden.getSample(channel, i)));
+
+    result.nullDb = 2.0 * toDb(residual);
+    result.passed = result.nullDb <= options.nullThresholdDb;
+
+    if (c.signal->frequency > 0.0)
+    {
+        result.hasSpectrum = true;
+        result.spectrum = analyse(output, c.signal->frequency, c.sampleRate);
+        result.goldenSpectrum = analyse(golden, c.signal->frequency, c.sampleRate);
+
+        result.passed = result.passed
+                     && std::abs(result.spectrum.thdDb - result.goldenSpectrum.thdDb) <= options.thdToleranceDb
+                     && result.spectrum.aliasDb - result.goldenSpectrum.aliasDb <= options.aliasToleranceDb;
+    }
+
+    return result;
+}
+
+juce::String formatResult(const Result& r)
+{
+    juce::String text = r.name.paddedRight(' ', 36);
+
+    if (r.error.isNotEmpty())
+        return text + "FAIL  " + r.error;
+
+    text << (r.passed ? "pass  " : "FAIL  ") << "null " << juce::String(r.nullDb, 1).paddedLeft(' ', 7) << " dB";
+
+    if (r.hasSpectrum)
+        text << "  thd " << juce::String(r.spectrum.thdDb, 2) << " dB (golden " << juce::String(r.goldenSpectrum.thdDb, 2)
+             << ")  alias " << juce::String(r.spectrum.aliasDb, 1) << " dB (golden "
+             << juce::String(r.goldenSpectrum.aliasDb, 1) << ")";
+
+    return text;
+}
+
+juce::String formatJson(const std::vector<Result>& results, const Options& options)
+{
+    juce::Array<juce::var> cases;
+
+    for (auto& r : results)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("name", r.name);
+        entry->setProperty("passed", r.passed);
+
+        if (r.error.isNotEmpty())
+            entry->setProperty("error", r.error);
+        else
+            entry->setProperty("nullDb", r.nullDb);
+
+        if (r.hasSpectrum)
+        {
+            entry->setProperty("thdDb", r.spectrum.thdDb);
+            entry->setProperty("goldenThdDb", r.goldenSpectrum.thdDb);
+            entry->setProperty("aliasDb", r.spectrum.aliasDb);
+            entry->setProperty("goldenAliasDb", r.goldenSpectrum.aliasDb);
+        }
+
+        cases.add(juce::var(entry));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("precision", options.doublePrecision ? "double" : "float");
+    root->setProperty("isa", ShaperKernels::getIsaName(ShaperKernels::getActiveIsa()));
+    root->setProperty("nullThresholdDb", options.nullThresholdDb);
+    root->setProperty("thdToleranceDb", options.thdToleranceDb);
+    root->setProperty("aliasToleranceDb", options.aliasToleranceDb);
+    root->setProperty("cases", cases);
+    return juce::JSON::toString(juce::var(root));
+}
+
+void printUsage()
+{
+    std::cout << "usage: TransformerRegression --golden-dir=dir [--generate] [--filter=text] [--double] [--isa=name]\n"
+                 "                             [--null-db=dB] [--thd-db=dB] [--alias-db=dB] [--json=file]" << std::endl;
+}
+
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    if (! args.containsOption("--golden-dir") || args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return args.containsOption("--help|-h") ? 0 : 1;
+    }
+
+    Options options;
+    options.goldenDirectory = args.getFileForOption("--golden-dir");
+    options.filter = args.getValueForOption("--filter");
+    options.generate = args.containsOption("--generate");
+    options.doublePrecision = args.containsOption("--double");
+
+    if (args.containsOption("--null-db"))
+        options.nullThresholdDb = args.getValueForOption("--null-db").getDoubleValue();
+
+    if (args.containsOption("--thd-db"))
+        options.thdToleranceDb = args.getValueForOption("--thd-db").getDoubleValue();
+
+    if (args.containsOption("--alias-db"))
+        options.aliasToleranceDb = args.getValueForOption("--alias-db").getDoubleValue();
+
+    // Pins the shaper kernel, so every instruction set's path can be checked against the same goldens
+    if (args.containsOption("--isa"))
+    {
+        const auto name = args.getValueForOption("--isa");
+        auto isa = ShaperKernels::Isa::scalar;
+
+        if (! ShaperKernels::findIsa(name.toRawUTF8(), isa) || ! ShaperKernels::forceIsa(isa))
+        {
+            std::cerr << "error: instruction set " << name << " is not available here" << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.generate && ! options.goldenDirectory.createDirectory())
+    {
+        std::cerr << "error: cannot create " << options.goldenDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    // Allocations in processBlock are counted rather than asserted, and fail the case
+    RealtimeAllocationGuard::setViolationHandler([](std::size_t) {});
+
+    std::vector<Result> results;
+    int numFailures = 0;
+
+    for (auto& parameters : parameterSets)
+        for (auto& signal : testSignals)
+            for (auto sampleRate : sampleRates)
+                for (auto blockSize : blockSizes)
+                {
+                    const Case c { &parameters, &signal, sampleRate, blockSize };
+                    const auto name = c.getName();
+
+                    if (options.filter.isNotEmpty() && ! name.contains(options.filter))
+                        continue;
+
+                    RealtimeAllocationGuard::resetViolationCount();
+                    const auto output = options.doublePrecision ? render<double>(c) : render<float>(c);
+                    const int numAllocations = RealtimeAllocationGuard::getViolationCount();
+
+                    if (options.generate)
+                    {
+                        if (numAllocations > 0)
+                        {
+                            std::cerr << "error: " << name << " made " << numAllocations
+                                      << " heap allocations on the audio thread" << std::endl;
+                            return 1;
+                        }
+
+                        if (! writeWav(options.goldenDirectory.getChildFile(name + ".wav"), output, sampleRate))
+                        {
+                            std::cerr << "error: cannot write golden render for " << name << std::endl;
+                            return 1;
+                        }
+
+                        std::cout << "wrote " << name << std::endl;
+                        continue;
+                    }
+
+                    results.push_back(verify(options, c, output, numAllocations));
+
+                    if (! results.back().passed)
+                        ++numFailures;
+
+                    std::cout << formatResult(results.back()) << std::endl;
+                }
+
+    if (options.generate)
+        return 0;
+
+    if (args.containsOption("--json"))
+    {
+        const auto jsonFile = args.getFileForOption("--json");
+
+        if (! jsonFile.replaceWithText(formatJson(results, options)))
+        {
+            std::cerr << "error: cannot write " << jsonFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << (results.size() - (size_t) numFailures) << " of " << results.size() << " cases passed" << std::endl;
+    return numFailures == 0 ? 0 : 1;
+}
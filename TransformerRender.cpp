@@ -0,0 +1,327 @@
+// Headless batch renderer: streams audio files through TransformerAudioProcessor
+// with the same DSP code and block processing as the plugin.
+//
+//   TransformerRender [options] <input files or directories...>
+//
+//   --state=<file>         Parameter state: the binary blob getStateInformation
+//                          writes (as a host stores it), or a value tree as XML
+//   --output-dir=<dir>     Where to write results (default: next to each input,
+//                          with a "_transformed" suffix)
+//   --format=<wav|flac>    Output format (default: same as the input)
+//   --bit-depth=<n>        Output bit depth (default: same as the input)
+//   --block-size=<n>       Samples per processBlock call (default: 512)
+//   --jobs=<n>             Files rendered in parallel (default: number of cores)
+//   --realtime             Render with the realtime oversampling setting instead
+//                          of the offline render quality
+//   --compensate-latency   Drop the processor latency from the start of the output
+//                          and flush the same number of samples at the end
+//   --double               Process at double precision
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "PluginProcessor.h"
+#include <iostream>
+#include <mutex>
+
+namespace
+{
+
+struct RenderSettings
+{
+    juce::MemoryBlock state;
+    juce::File outputDirectory;
+    juce::String format;
+    int bitDepth = 0;
+    int blockSize = 512;
+    bool realtime = false;
+    bool compensateLatency = false;
+    bool doublePrecision = false;
+};
+
+// Accepts either the XML text of a value tree or the binary blob from getStateInformation
+bool loadState(const juce::File& file, juce::MemoryBlock& destData)
+{
+    if (auto xml = juce::parseXML(file))
+    {
+        juce::AudioProcessor::copyXmlToBinary(*xml, destData);
+        return true;
+    }
+
+    return file.loadFileAsData(destData) && destData.getSize() > 0;
+}
+
+juce::AudioFormat* findOutputFormat(juce::AudioFormatManager& formats, const RenderSettings& settings,
+                                    const juce::File& inputFile)
+{
+    if (settings.format.isNotEmpty())
+        return formats.findFormatForFileExtension(settings.format);
+
+    return formats.findFormatForFileExtension(inputFile.getFileExtension());
+}
+
+juce::File getOutputFile(const RenderSettings& settings, const juce::File& inputFile, juce::AudioFormat& format)
+{
+    const auto extension = format.getFileExtensions()[0];
+
+    if (settings.outputDirectory != juce::File())
+        return settings.outputDirectory.getChildFile(inputFile.getFileNameWithoutExtension() + extension);
+
+    return inputFile.getSiblingFile(inputFile.getFileNameWithoutExtension() + "_transformed" + extension);
+}
+
+//==============================================================================
+class RenderJob : public juce::ThreadPoolJob
+{
+public:
+    RenderJob(const juce::File& input, const RenderSettings& settingsToUse, std::atomic<int>& failureCount)
+        : juce::ThreadPoolJob(input.getFileName()), inputFile(input), settings(settingsToUse), failures(failureCount)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        juce::String error;
+
+        if (render(error))
+            log(inputFile.getFullPathName() + " -> " + outputPath);
+        else
+        {
+            ++failures;
+            log("error: " + inputFile.getFullPathName() + ": " + error);
+        }
+
+        return jobHasFinished;
+    }
+
+private:
+    bool render(juce::String& error)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(inputFile));
+
+        if (reader == nullptr)
+            return fail(error, "unsupported or unreadable file");
+
+        auto* outputFormat = findOutputFormat(formats, settings, inputFile);
+
+        if (outputFormat == nullptr)
+            return fail(error, "unknown output format");
+
+        const int numChannels = (int) reader->numChannels;
+        const double sampleRate = reader->sampleRate;
+        const int blockSize = settings.blockSize;
+
+        TransformerAudioProcessor processor;
+
+        // Main buses only; the sidechain bus stays disabled
+        auto layout = processor.getBusesLayout();
+        layout.inputBuses.getReference(0) = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+        layout.outputBuses.getReference(0) = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+        if (! processor.setBusesLayout(layout))
+            return fail(error, juce::String(numChannels) + " channel layout not supported");
+
+        if (settings.state.getSize() > 0)
+            processor.setStateInformation(settings.state.getData(), (int) settings.state.getSize());
+
+        processor.setNonRealtime(! settings.realtime);
+        processor.setProcessingPrecision(settings.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                  : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        int bitDepth = settings.bitDepth > 0 ? settings.bitDepth : (int) reader->bitsPerSample;
+
+        if (! outputFormat->getPossibleBitDepths().contains(bitDepth))
+            bitDepth = outputFormat->getPossibleBitDepths().getLast();
+
+        const auto outputFile = getOutputFile(settings, inputFile, *outputFormat);
+        outputPath = outputFile.getFullPathName();
+        outputFile.deleteFile();
+
+        auto stream = std::make_unique<juce::FileOutputStream>(outputFile);
+
+        if (! stream->openedOk())
+            return fail(error, "cannot write " + outputPath);
+
+        std::unique_ptr<juce::AudioFormatWriter> writer(outputFormat->createWriterFor(stream.get(), sampleRate,
+                                                                                     (unsigned int) numChannels,
+                                                                                     bitDepth, {}, 0));
+
+        if (writer == nullptr)
+            return fail(error, "cannot create writer");
+
+        stream.release(); // now owned by the writer
+
+        // Input is streamed one block at a time, so memory stays bounded
+        juce::AudioBuffer<float> buffer(numChannels, blockSize);
+        juce::AudioBuffer<double> doubleBuffer(settings.doublePrecision ? numChannels : 0, blockSize);
+        juce::MidiBuffer midi;
+
+        const juce::int64 totalSamples = reader->lengthInSamples;
+        int samplesToSkip = settings.compensateLatency ? processor.getLatencySamples() : 0;
+        const juce::int64 totalToRender = totalSamples + samplesToSkip;
+
+        for (juce::int64 position = 0; position < totalToRender; position += blockSize)
+        {
+            if (shouldExit())
+                return fail(error, "cancelled");
+
+            const int numSamples = (int) juce::jmin((juce::int64) blockSize, totalToRender - position);
+            buffer.setSize(numChannels, numSamples, false, false, true);
+
+            // Past the end of the file the latency is flushed with silence
+            reader->read(&buffer, 0, numSamples, position, true, true);
+
+            if (settings.doublePrecision)
+            {
+                doubleBuffer.makeCopyOf(buffer, true);
+                processor.processBlock(doubleBuffer, midi);
+                buffer.makeCopyOf(doubleBuffer, true);
+            }
+            else
+            {
+                processor.processBlock(buffer, midi);
+            }
+
+            const int skip = juce::jmin(samplesToSkip, numSamples);
+            samplesToSkip -= skip;
+
+            if (skip < numSamples && ! writer->writeFromAudioSampleBuffer(buffer, skip, numSamples - skip))
+                return fail(error, "write failed");
+        }
+
+        processor.releaseResources();
+        return true;
+    }
+
+    static bool fail(juce::String& error, const juce::String& message)
+    {
+        error = message;
+        return false;
+    }
+
+    static void log(const juce::String& message)
+    {
+        static std::mutex logLock;
+        const std::lock_guard<std::mutex> lock(logLock);
+        std::cout << message << std::endl;
+    }
+
+    juce::File inputFile;
+    const RenderSettings& settings;
+    std::atomic<int>& failures;
+    juce::String outputPath;
+};
+
+void printUsage()
+{
+    std::cout << "usage: TransformerRender [--state=file] [--output-dir=dir] [--format=wav|flac]\n"
+                 "                         [--bit-depth=n] [--block-size=n] [--jobs=n] [--realtime]\n"
+                 "                         [--compensate-latency] [--double] inputs..." << std::endl;
+}
+
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    if (args.size() == 0 || args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return args.size() == 0 ? 1 : 0;
+    }
+
+    RenderSettings settings;
+
+    if (args.containsOption("--state"))
+    {
+        const auto stateFile = args.getFileForOption("--state");
+
+        if (! loadState(stateFile, settings.state))
+        {
+            std::cerr << "error: cannot read state from " << stateFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    if (args.containsOption("--output-dir"))
+    {
+        settings.outputDirectory = args.getFileForOption("--output-dir");
+
+        if (! settings.outputDirectory.createDirectory())
+        {
+            std::cerr << "error: cannot create " << settings.outputDirectory.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    if (args.containsOption("--format"))
+        settings.format = "." + args.getValueForOption("--format").trimCharactersAtStart(".");
+
+    if (args.containsOption("--bit-depth"))
+        settings.bitDepth = args.getValueForOption("--bit-depth").getIntValue();
+
+    if (args.containsOption("--block-size"))
+        settings.blockSize = juce::jmax(1, args.getValueForOption("--block-size").getIntValue());
+
+    settings.realtime = args.containsOption("--realtime");
+    settings.compensateLatency = args.containsOption("--compensate-latency");
+    settings.doublePrecision = args.containsOption("--double");
+
+    int numJobs = juce::SystemStats::getNumCpus();
+
+    if (args.containsOption("--jobs"))
+        numJobs = juce::jmax(1, args.getValueForOption("--jobs").getIntValue());
+
+    // Everything that isn't an option is an input file or a directory of them
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    juce::Array<juce::File> inputs;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        // Long options carry their value after '='
+        if (arg.isOption())
+            continue;
+
+        const auto file = arg.resolveAsFile();
+
+        if (file.isDirectory())
+            inputs.addArray(file.findChildFiles(juce::File::findFiles, true, formats.getWildcardForAllFormats()));
+        else
+            inputs.add(file);
+    }
+
+    if (inputs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::atomic<int> failures { 0 };
+
+    {
+        // Declared before the pool, so the pool has let go of every job by the
+        // time they are deleted
+        juce::OwnedArray<RenderJob> jobs;
+        juce::ThreadPool pool(numJobs);
+
+        for (auto& input : inputs)
+            pool.addJob(jobs.add(new RenderJob(input, settings, failures)), false);
+
+        // Blocks until each job is done, without polling
+        for (auto* job : jobs)
+            pool.waitForJobToFinish(job, -1);
+    }
+
+    std::cout << inputs.size() - failures.load() << " of " << inputs.size() << " files rendered" << std::endl;
+    return failures.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+// Checks the plugin state format (see ParameterSnapshots) through the processor's
+// getStateInformation / setStateInformation:
+//
+//   round trip       a state with snapshots loads into a fresh processor with
+//                    the same values and snapshots, without any change gesture
+//   truncated        every prefix of that state is rejected and changes nothing
+//   unknown version  a state from a newer version is rejected and changes nothing
+//   XML fallback     a value tree saved as XML by earlier versions still loads,
+//                    and clears the snapshots
+//
+// Run by CTest; exits with 1 on any failure.
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "PluginProcessor.h"
+#include "ParameterSnapshots.h"
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+void setParameter(TransformerAudioProcessor& processor, const juce::String& id, float value)
+{
+    if (auto* parameter = processor.parameters.getParameter(id))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+// Something other than the defaults everywhere the state can hold it: live
+// values, two stored snapshots and a snapshot parameter outside the snapshots
+void setUpState(TransformerAudioProcessor& processor)
+{
+    setParameter(processor, "drive", 4.0f);
+    setParameter(processor, "hysteresis", 0.6f);
+    setParameter(processor, "numBands", 2.0f);
+    processor.storeSnapshot(0);
+
+    setParameter(processor, "drive", 1.5f);
+    setParameter(processor, "hysteresisModel", 1.0f);
+    setParameter(processor, "crossover2", 3000.0f);
+    processor.storeSnapshot(2);
+
+    setParameter(processor, "evenHarmonics", 0.9f);
+    setParameter(processor, "oversampling", 2.0f);
+    setParameter(processor, "preisachResolution", 3.0f);
+}
+
+// Plain values agree to float rounding, which a value can pick up going through
+// the parameter range and back
+bool haveSameValues(juce::AudioProcessor& a, juce::AudioProcessor& b)
+{
+    const auto parametersA = a.getParameters();
+    const auto parametersB = b.getParameters();
+
+    if (parametersA.size() != parametersB.size())
+        return false;
+
+    for (int i = 0; i < parametersA.size(); ++i)
+    {
+        auto* rangedA = dynamic_cast<juce::RangedAudioParameter*>(parametersA[i]);
+        auto* rangedB = dynamic_cast<juce::RangedAudioParameter*>(parametersB[i]);
+
+        if (rangedA == nullptr || rangedB == nullptr || rangedA->getParameterID() != rangedB->getParameterID())
+            return false;
+
+        const float valueA = rangedA->convertFrom0to1(rangedA->getValue());
+        const float valueB = rangedB->convertFrom0to1(rangedB->getValue());
+
+        if (std::abs(valueA - valueB) > 1.0e-5f * juce::jmax(1.0f, std::abs(valueA)))
+            return false;
+    }
+
+    return true;
+}
+
+juce::MemoryBlock getState(TransformerAudioProcessor& processor)
+{
+    juce::MemoryBlock block;
+    processor.getStateInformation(block);
+    return block;
+}
+
+// Counts change gestures, which hosts record as user edits
+struct GestureCounter : private juce::AudioProcessorParameter::Listener
+{
+    explicit GestureCounter(juce::AudioProcessor& processorToWatch)
+        : processor(processorToWatch)
+    {
+        for (auto* parameter : processor.getParameters())
+            parameter->addListener(this);
+    }
+
+    ~GestureCounter() override
+    {
+        for (auto* parameter : processor.getParameters())
+            parameter->removeListener(this);
+    }
+
+    void parameterValueChanged(int, float) override {}
+    void parameterGestureChanged(int, bool) override { ++numGestures; }
+
+    juce::AudioProcessor& processor;
+    int numGestures = 0;
+};
+
+bool checkRoundTrip()
+{
+    TransformerAudioProcessor source;
+    setUpState(source);
+    const auto state = getState(source);
+
+    TransformerAudioProcessor restored;
+    GestureCounter gestures(restored);
+    restored.setStateInformation(state.getData(), (int) state.getSize());
+
+    bool passed = haveSameValues(source, restored) && gestures.numGestures == 0;
+
+    // Each snapshot recalls the same sound on both
+    for (int snapshot = 0; snapshot < ParameterSnapshots::kNumSnapshots; ++snapshot)
+    {
+        passed = passed && restored.isSnapshotStored(snapshot) == source.isSnapshotStored(snapshot);
+
+        if (source.isSnapshotStored(snapshot))
+        {
+            source.recallSnapshot(snapshot);
+            restored.recallSnapshot(snapshot);
+            passed = passed && haveSameValues(source, restored);
+        }
+    }
+
+    return passed;
+}
+
+// Loading the damaged state must leave the target exactly as it was
+bool leavesStateUnchanged(const void* data, int sizeInBytes)
+{
+    TransformerAudioProcessor target;
+    setParameter(target, "outputGain", -6.0f);
+    target.storeSnapshot(1);
+    const auto before = getState(target);
+
+    target.setStateInformation(data, sizeInBytes);
+    return getState(target) == before;
+}
+
+bool checkTruncated()
+{
+    TransformerAudioProcessor source;
+    setUpState(source);
+    const auto state = getState(source);
+
+    for (size_t size = 0; size < state.getSize(); ++size)
+        if (! leavesStateUnchanged(state.getData(), (int) size))
+            return false;
+
+    return true;
+}
+
+bool checkUnknownVersion()
+{
+    TransformerAudioProcessor source;
+    setUpState(source);
+    auto state = getState(source);
+
+    // The version byte follows the four byte magic
+    static_cast<char*>(state.getData())[4] = (char) (ParameterSnapshots::kStateVersion + 1);
+    return leavesStateUnchanged(state.getData(), (int) state.getSize());
+}
+
+bool checkXmlFallback()
+{
+    TransformerAudioProcessor source;
+    setUpState(source);
+
+    juce::MemoryBlock xmlState;
+    auto xml = source.parameters.copyState().createXml();
+    juce::AudioProcessor::copyXmlToBinary(*xml, xmlState);
+
+    TransformerAudioProcessor restored;
+    restored.storeSnapshot(3);
+    restored.setStateInformation(xmlState.getData(), (int) xmlState.getSize());
+
+    bool passed = haveSameValues(source, restored);
+
+    for (int snapshot = 0; snapshot < ParameterSnapshots::kNumSnapshots; ++snapshot)
+        passed = passed && ! restored.isSnapshotStored(snapshot);
+
+    return passed;
+}
+
+} // namespace
+
+//==============================================================================
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const std::pair<const char*, std::function<bool()>> checks[] =
+    {
+        { "round trip", checkRoundTrip },
+        { "truncated state", checkTruncated },
+        { "unknown version", checkUnknownVersion },
+        { "XML fallback", checkXmlFallback },
+    };
+
+    int numFailures = 0;
+
+    for (auto& check : checks)
+    {
+        const bool passed = check.second();
+        numFailures += passed ? 0 : 1;
+        std::cout << check.first << ": " << (passed ? "ok" : "FAILED") << std::endl;
+    }
+
+    return numFailures == 0 ? 0 : 1;
+}